@@ -53,8 +53,12 @@ struct nocl_ip_info {
 };
 struct nocl_info {
 	const char *nocl_name;
+	bool is_bus1;
 	u32 num_ip;
 	u32 peak_freq;
+	u32 total_rd_bw;
+	u32 total_wr_bw;
+	u32 max_ip_peak_freq;
 	struct nocl_ip_info *nocl_ips;
 	struct list_head list;
 };
@@ -78,6 +82,12 @@ struct nocl_info {
  * @bts_bw:	struct bts_bw * - struct for saving bandwidth information
  * @peak_bw:	currently max bandwidth
  * @total_bw:	current total bandwidth
+ * @total_read:	running sum of read bandwidth votes
+ * @total_write: running sum of write bandwidth votes
+ * @rt_bw:	running sum of RT bandwidth votes
+ * @max_peak:	largest peak bandwidth vote of a single client
+ * @mif_freq:	MIF frequency last requested through PM QoS
+ * @int_freq:	INT frequency last requested through PM QoS
  *
  * This structure stores basic BTS information for QoS control
  *
@@ -105,6 +115,12 @@ struct bts_device {
 	const char **rt_names;
 	unsigned int peak_bw;
 	unsigned int total_bw;
+	unsigned int total_read;
+	unsigned int total_write;
+	unsigned int rt_bw;
+	unsigned int max_peak;
+	unsigned int mif_freq;
+	unsigned int int_freq;
 	struct bus1_int_map *bus1_int_tbl;
 	unsigned int map_row_cnt;
 
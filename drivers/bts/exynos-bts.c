@@ -151,39 +151,91 @@ static void bts_update_urgent_lat_req(unsigned int bus1_freq)
 }
 #endif
 
+#if IS_ENABLED(CONFIG_SOC_ZUMA)
+static inline unsigned int bts_ip_peak_freq(struct bts_bw *bw)
+{
+	return (bw->peak / bw->bus_width) * 100 / INT_UTIL;
+}
+#endif
+
+/*
+ * Fold a new vote of client @index into the running sums. Must be called with
+ * btsdev->lock held, before the client's bts_bw is overwritten.
+ */
+static void bts_account_bw(unsigned int index, struct bts_bw *bw)
+{
+	struct bts_bw *cur = &btsdev->bts_bw[index];
+	unsigned int rt = cur->is_rt ? bw->rt : cur->rt;
+#if IS_ENABLED(CONFIG_SOC_ZUMA)
+	struct nocl_info *nocl = cur->nocl;
+	unsigned int old_freq, new_freq;
+	struct bts_bw *ip;
+#else
+	unsigned int i;
+#endif
+
+	btsdev->total_read += bw->read - cur->read;
+	btsdev->total_write += bw->write - cur->write;
+	btsdev->rt_bw += rt - cur->rt;
+
+#if IS_ENABLED(CONFIG_SOC_ZUMA)
+	if (!nocl)
+		return;
+
+	nocl->total_rd_bw += bw->read - cur->read;
+	nocl->total_wr_bw += bw->write - cur->write;
+
+	old_freq = bts_ip_peak_freq(cur);
+	cur->peak = bw->peak;
+	new_freq = bts_ip_peak_freq(cur);
+	if (new_freq >= nocl->max_ip_peak_freq) {
+		nocl->max_ip_peak_freq = new_freq;
+	} else if (old_freq == nocl->max_ip_peak_freq) {
+		/* The client holding the maximum lowered its vote */
+		nocl->max_ip_peak_freq = 0;
+		list_for_each_entry(ip, &nocl->list, node)
+			nocl->max_ip_peak_freq = max(nocl->max_ip_peak_freq,
+						     bts_ip_peak_freq(ip));
+	}
+#else
+	if (bw->peak >= btsdev->max_peak) {
+		btsdev->max_peak = bw->peak;
+	} else if (cur->peak == btsdev->max_peak) {
+		/* The client holding the maximum lowered its vote */
+		cur->peak = bw->peak;
+		btsdev->max_peak = 0;
+		for (i = 0; i < btsdev->num_bts; i++)
+			btsdev->max_peak = max(btsdev->max_peak, btsdev->bts_bw[i].peak);
+	}
+#endif
+}
+
 static void bts_calc_bw(void)
 {
 	unsigned int i;
-	unsigned int total_read = 0;
-	unsigned int total_write = 0;
-	unsigned int rt_bw = 0;
-	unsigned int mif_freq, int_freq, bus1_freq = 0;
+	unsigned int total_read;
+	unsigned int total_write;
+	unsigned int rt_bw;
+	unsigned int mif_freq, int_freq = 0, bus1_freq = 0;
 #if IS_ENABLED(CONFIG_SOC_ZUMA)
-	struct bts_bw *bw;
-	unsigned int nocl_total_rd_bw;
-	unsigned int nocl_total_wr_bw;
+	struct nocl_info *nocl;
 	unsigned int nocl_peak_freq;
-	char buf[80];
+	char buf[80] = "";
 	ssize_t ret = 0;
 #endif
 
 	mutex_lock(&btsdev->mutex_lock);
 
+	spin_lock(&btsdev->lock);
+	total_read = btsdev->total_read;
+	total_write = btsdev->total_write;
+	rt_bw = btsdev->rt_bw;
+#if IS_ENABLED(CONFIG_SOC_ZUMA)
 	btsdev->peak_bw = 0;
-	btsdev->total_bw = 0;
-
-	for (i = 0; i < btsdev->num_bts; i++) {
-#if !IS_ENABLED(CONFIG_SOC_ZUMA)
-		if (btsdev->peak_bw < btsdev->bts_bw[i].peak)
-			btsdev->peak_bw = btsdev->bts_bw[i].peak;
+#else
+	btsdev->peak_bw = btsdev->max_peak;
 #endif
-		/* Calculate total RT BW based on RT clients */
-		if (btsdev->bts_bw[i].is_rt)
-			rt_bw += btsdev->bts_bw[i].rt;
-
-		total_read += btsdev->bts_bw[i].read;
-		total_write += btsdev->bts_bw[i].write;
-	}
+	spin_unlock(&btsdev->lock);
 
 	btsdev->total_bw = total_read + total_write;
 	if (btsdev->peak_bw < (total_read / NUM_CHANNEL))
@@ -197,50 +249,42 @@ static void bts_calc_bw(void)
 
 #if IS_ENABLED(CONFIG_SOC_ZUMA)
 	for (i = 0; i < btsdev->num_nocl ; i++) {
-		nocl_total_rd_bw = 0;
-		nocl_total_wr_bw = 0;
-		btsdev->nocl_infos[i].peak_freq = 0;
-		list_for_each_entry(bw, &btsdev->nocl_infos[i].list, node) {
-			nocl_total_rd_bw += bw->read;
-			nocl_total_wr_bw += bw->write;
-			nocl_peak_freq = (bw->peak / bw->bus_width) * 100 / INT_UTIL;
-			if (btsdev->nocl_infos[i].peak_freq < nocl_peak_freq)
-				btsdev->nocl_infos[i].peak_freq = nocl_peak_freq;
-		}
-		if (!strcmp(btsdev->nocl_infos[i].nocl_name, "nocl2aa") ||
-		    !strcmp(btsdev->nocl_infos[i].nocl_name, "nocl2ab")) {
+		nocl = &btsdev->nocl_infos[i];
+
+		spin_lock(&btsdev->lock);
+		nocl->peak_freq = nocl->max_ip_peak_freq;
+		if (nocl->is_bus1) {
 			/* In Zuma, the equivalent of bus1 is NOCL2AA & NOCL2AB
 			 * so first calculate the required frequency for these
 			 * two nocls to get the bus1_freq.
 			 */
-			nocl_peak_freq = (nocl_total_rd_bw / INT_BUS_WIDTH) /
+			nocl_peak_freq = (nocl->total_rd_bw / INT_BUS_WIDTH) /
 				NOCL2A_NUM_CHANNEL * 100 / INT_UTIL;
-			btsdev->nocl_infos[i].peak_freq = max(nocl_peak_freq,
-				btsdev->nocl_infos[i].peak_freq);
-			nocl_peak_freq = (nocl_total_wr_bw / INT_BUS_WIDTH) /
+			nocl->peak_freq = max(nocl_peak_freq, nocl->peak_freq);
+			nocl_peak_freq = (nocl->total_wr_bw / INT_BUS_WIDTH) /
 				NOCL2A_NUM_CHANNEL * 100 / INT_UTIL;
-			btsdev->nocl_infos[i].peak_freq = max(nocl_peak_freq,
-				btsdev->nocl_infos[i].peak_freq);
-			bus1_freq = max(bus1_freq, btsdev->nocl_infos[i].peak_freq);
+			nocl->peak_freq = max(nocl_peak_freq, nocl->peak_freq);
+			bus1_freq = max(bus1_freq, nocl->peak_freq);
 		} else {
 			/* This block is to calculate the required frequency
 			 * of NOCL1A.
 			 */
 			nocl_peak_freq = (total_read / INT_BUS_WIDTH) /
 				NUM_CHANNEL * 100 / INT_UTIL;
-			btsdev->nocl_infos[i].peak_freq = max(nocl_peak_freq,
-				btsdev->nocl_infos[i].peak_freq);
+			nocl->peak_freq = max(nocl_peak_freq, nocl->peak_freq);
 			nocl_peak_freq = (total_write / INT_BUS_WIDTH) /
 				NUM_CHANNEL * 100 / INT_UTIL;
-			btsdev->nocl_infos[i].peak_freq = max(nocl_peak_freq,
-				btsdev->nocl_infos[i].peak_freq);
-			int_freq = btsdev->nocl_infos[i].peak_freq;
+			nocl->peak_freq = max(nocl_peak_freq, nocl->peak_freq);
+			int_freq = nocl->peak_freq;
 		}
-		ret += scnprintf(buf + ret, sizeof(buf) - ret, "%s:%.8u ",
-				 btsdev->nocl_infos[i].nocl_name,
-				 btsdev->nocl_infos[i].peak_freq);
+		spin_unlock(&btsdev->lock);
+
+		if (btsdbg_log)
+			ret += scnprintf(buf + ret, sizeof(buf) - ret, "%s:%.8u ",
+					 nocl->nocl_name, nocl->peak_freq);
 	}
-	BTSDBG_LOG(btsdev->dev, "Freq: %s\n", buf);
+	if (btsdbg_log)
+		BTSDBG_LOG(btsdev->dev, "Freq: %s\n", buf);
 
 	/* Calculate the final INT frequency based on NOCL2AA, NOCL2AB & NOCL1A */
 	int_freq = max(int_freq, bus1_to_int_freq(bus1_freq));
@@ -259,16 +303,27 @@ static void bts_calc_bw(void)
 		   btsdev->total_bw, total_read, total_write, btsdev->peak_bw, rt_bw,
 		   mif_freq, bus1_freq, int_freq);
 #endif
-	trace_clock_set_rate("BTS_mif_freq", mif_freq, raw_smp_processor_id());
-	trace_clock_set_rate("BTS_int_freq", int_freq, raw_smp_processor_id());
 
+	/* Most votes do not move the derived frequencies, skip the QoS requests then */
+	if (mif_freq != btsdev->mif_freq) {
+		btsdev->mif_freq = mif_freq;
+		trace_clock_set_rate("BTS_mif_freq", mif_freq, raw_smp_processor_id());
+#if IS_ENABLED(CONFIG_EXYNOS_PM_QOS)
+		exynos_pm_qos_update_request(&exynos_mif_qos, mif_freq);
+#else
+		pm_qos_update_request(&exynos_mif_qos, mif_freq);
+#endif
+	}
+
+	if (int_freq != btsdev->int_freq) {
+		btsdev->int_freq = int_freq;
+		trace_clock_set_rate("BTS_int_freq", int_freq, raw_smp_processor_id());
 #if IS_ENABLED(CONFIG_EXYNOS_PM_QOS)
-	exynos_pm_qos_update_request(&exynos_mif_qos, mif_freq);
-	exynos_pm_qos_update_request(&exynos_int_qos, int_freq);
+		exynos_pm_qos_update_request(&exynos_int_qos, int_freq);
 #else
-	pm_qos_update_request(&exynos_mif_qos, mif_freq);
-	pm_qos_update_request(&exynos_int_qos, int_freq);
+		pm_qos_update_request(&exynos_int_qos, int_freq);
 #endif
+	}
 	mutex_unlock(&btsdev->mutex_lock);
 }
 
@@ -440,6 +495,7 @@ int bts_get_bwindex(const char *name)
 				list_add(&bw[index].node, &btsdev->nocl_infos[i].list);
 				bw[index].bus_width =
 					btsdev->nocl_infos[i].nocl_ips[j].ip_bus_width;
+				bw[index].nocl = &btsdev->nocl_infos[i];
 			}
 		}
 	}
@@ -536,6 +592,7 @@ int bts_update_bw(unsigned int index, struct bts_bw bw)
 	struct bts_bw *bts_bw = btsdev->bts_bw;
 	unsigned int total_bw;
 	char trace_name[32];
+	bool changed;
 
 	if (index >= btsdev->num_bts) {
 		dev_err(btsdev->dev,
@@ -553,6 +610,11 @@ int bts_update_bw(unsigned int index, struct bts_bw bw)
 	}
 
 	spin_lock(&btsdev->lock);
+	changed = bts_bw[index].peak != bw.peak || bts_bw[index].read != bw.read ||
+		  bts_bw[index].write != bw.write ||
+		  (bts_bw[index].is_rt && bts_bw[index].rt != bw.rt);
+	if (changed)
+		bts_account_bw(index, &bw);
 	bts_bw[index].peak = bw.peak;
 	bts_bw[index].read = bw.read;
 	bts_bw[index].write = bw.write;
@@ -575,7 +637,8 @@ int bts_update_bw(unsigned int index, struct bts_bw bw)
 		   "%s R: %.8u W: %.8u P: %.8u RT: %.8u\n",
 		   bts_bw[index].name, bw.read, bw.write, bw.peak, bts_bw[index].rt);
 
-	bts_calc_bw();
+	if (changed)
+		bts_calc_bw();
 	bts_update_stats(index);
 
 	return 0;
@@ -1879,9 +1942,9 @@ static int bts_parse_data(struct device_node *np, struct bts_device *data)
 			goto err;
 		}
 		if (!strcmp(data->nocl_infos[i].nocl_name, "nocl2aa"))
-			has_nocl2aa = true;
+			has_nocl2aa = data->nocl_infos[i].is_bus1 = true;
 		else if (!strcmp(data->nocl_infos[i].nocl_name, "nocl2ab"))
-			has_nocl2ab = true;
+			has_nocl2ab = data->nocl_infos[i].is_bus1 = true;
 	}
 	if (!has_nocl2aa || !has_nocl2ab) {
 		dev_err(data->dev,
@@ -26,6 +26,7 @@
 #include <linux/bug.h>
 #include <linux/cpumask.h>
 #include <linux/of_address.h>
+#include <linux/percpu.h>
 #include <asm/unaligned.h>
 
 #include "dmaengine.h"
@@ -374,10 +375,22 @@ enum pl330_cond {
 
 struct dma_pl330_desc;
 
+/* Everything a request's microcode depends on, apart from SAR and DAR */
+struct _pl330_mc_key {
+	u32 ccr;
+	u32 bytes;
+	unsigned int infiniteloop;
+	enum dma_transfer_direction rqtype;
+	unsigned int peri;
+};
+
 struct _pl330_req {
 	u32 mc_bus;
 	void *mc_cpu;
 	struct dma_pl330_desc *desc;
+	/* Key of the program left in mc_cpu, if mc_valid */
+	struct _pl330_mc_key mc_key;
+	bool mc_valid;
 };
 
 /* ToBeDone for tasklet */
@@ -478,6 +491,13 @@ struct dma_pl330_chan {
 	bool active;
 };
 
+/* Per-CPU free list of descriptors */
+struct pl330_desc_pool {
+	struct list_head list;
+	/* To protect list manipulation */
+	spinlock_t lock;
+};
+
 struct pl330_dmac {
 	/* DMA-Engine Device */
 	struct dma_device ddma;
@@ -485,10 +505,12 @@ struct pl330_dmac {
 	/* Holds info about sg limitations */
 	struct device_dma_parameters dma_parms;
 
-	/* Pool of descriptors available for the DMAC's channels */
-	struct list_head desc_pool;
-	/* To protect desc_pool manipulation */
-	spinlock_t pool_lock;
+	/*
+	 * Pools of descriptors available for the DMAC's channels. Descriptors
+	 * go back to the pool of the CPU freeing them, so prep and completion
+	 * on different CPUs don't contend on one lock.
+	 */
+	struct pl330_desc_pool __percpu *desc_pool;
 
 	/* Size of MicroCode buffers for each channel. */
 	unsigned mcbufsz;
@@ -1686,6 +1708,41 @@ static int _setup_req(struct pl330_dmac *pl330, unsigned int dry_run,
 	return off;
 }
 
+static inline void _mc_key(struct _pl330_mc_key *key,
+			   const struct _xfer_spec *pxs)
+{
+	key->ccr = pxs->ccr;
+	key->bytes = pxs->desc->px.bytes;
+	key->infiniteloop = pxs->desc->infiniteloop;
+	key->rqtype = pxs->desc->rqtype;
+	key->peri = pxs->desc->peri;
+}
+
+static inline bool _mc_cached(const struct _pl330_req *req,
+			      const struct _pl330_mc_key *key)
+{
+	return req->mc_valid &&
+		req->mc_key.ccr == key->ccr &&
+		req->mc_key.bytes == key->bytes &&
+		req->mc_key.infiniteloop == key->infiniteloop &&
+		req->mc_key.rqtype == key->rqtype &&
+		req->mc_key.peri == key->peri;
+}
+
+/*
+ * Point a cached program at the new req's buffers. Both _setup_xfer() and
+ * _loop_infiniteloop() emit DMAMOV SAR and DMAMOV DAR right after DMAMOV CCR,
+ * and no other instruction depends on the addresses.
+ */
+static inline void _patch_req(struct _pl330_req *req,
+			      const struct _xfer_spec *pxs)
+{
+	u8 *buf = req->mc_cpu;
+
+	_emit_MOV(0, &buf[SZ_DMAMOV], SAR, pxs->desc->px.src_addr);
+	_emit_MOV(0, &buf[2 * SZ_DMAMOV], DAR, pxs->desc->px.dst_addr);
+}
+
 static inline u32 _prepare_ccr(const struct pl330_reqcfg *rqc)
 {
 	u32 ccr = 0;
@@ -1727,6 +1784,7 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 				struct dma_pl330_desc *desc)
 {
 	struct pl330_dmac *pl330 = thrd->dmac;
+	struct _pl330_mc_key key;
 	struct _xfer_spec xs;
 	unsigned long flags;
 	unsigned int idx;
@@ -1784,6 +1842,19 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	xs.ccr = ccr;
 	xs.desc = desc;
 
+	/*
+	 * Peripheral clients tend to repeat the same length with the same
+	 * config, so the program left in this slot usually only needs the
+	 * new addresses.
+	 */
+	_mc_key(&key, &xs);
+	if (_mc_cached(&thrd->req[idx], &key)) {
+		thrd->lstenq = idx;
+		thrd->req[idx].desc = desc;
+		_patch_req(&thrd->req[idx], &xs);
+		goto hook_done;
+	}
+
 	/* First dry run to check if req is acceptable */
 	ret = _setup_req(pl330, 1, thrd, idx, &xs);
 	if (ret < 0)
@@ -1800,6 +1871,10 @@ static int pl330_submit_req(struct pl330_thread *thrd,
 	thrd->lstenq = idx;
 	thrd->req[idx].desc = desc;
 	_setup_req(pl330, 0, thrd, idx, &xs);
+	thrd->req[idx].mc_key = key;
+	thrd->req[idx].mc_valid = true;
+
+hook_done:
 
 	if (np && pl330->wrapper) {
 		__raw_writel((xs.desc->px.src_addr >> 32) & 0xf, thrd->ar_wrapper);
@@ -1815,6 +1890,8 @@ xfer_exit:
 }
 
 static void pl330_tasklet(unsigned long data);
+static void put_desc(struct pl330_dmac *pl330, struct dma_pl330_desc *desc);
+static void put_desc_list(struct pl330_dmac *pl330, struct list_head *list);
 
 static void dma_pl330_rqcb(struct dma_pl330_desc *desc, enum pl330_op_err err)
 {
@@ -2064,6 +2141,9 @@ static struct pl330_thread *pl330_request_channel(struct pl330_dmac *pl330)
 				thrd->lstenq = 1;
 				thrd->req[0].desc = NULL;
 				thrd->req[1].desc = NULL;
+				/* Cached programs SEV the previous owner's event */
+				thrd->req[0].mc_valid = false;
+				thrd->req[1].mc_valid = false;
 				thrd->req_running = -1;
 				pl330->usage_count++;
 				break;
@@ -2156,12 +2236,14 @@ static inline void _reset_thread(struct pl330_thread *thrd)
 	thrd->req[0].mc_bus = pl330->mcode_bus
 				+ (thrd->id * pl330->mcbufsz);
 	thrd->req[0].desc = NULL;
+	thrd->req[0].mc_valid = false;
 
 	thrd->req[1].mc_cpu = thrd->req[0].mc_cpu
 				+ pl330->mcbufsz / 2;
 	thrd->req[1].mc_bus = thrd->req[0].mc_bus
 				+ pl330->mcbufsz / 2;
 	thrd->req[1].desc = NULL;
+	thrd->req[1].mc_valid = false;
 
 	thrd->req_running = -1;
 }
@@ -2426,9 +2508,7 @@ static void pl330_tasklet(unsigned long data)
 			}
 		} else {
 			desc->status = FREE;
-			spin_lock(&pch->dmac->pool_lock);
-			list_move_tail(&desc->node, &pch->dmac->desc_pool);
-			spin_unlock(&pch->dmac->pool_lock);
+			put_desc(pch->dmac, desc);
 		}
 
 		dma_descriptor_unmap(&desc->txd);
@@ -2620,9 +2700,9 @@ static int pl330_terminate_all(struct dma_chan *chan)
 		dma_cookie_complete(&desc->txd);
 	}
 
-	list_splice_tail_init(&pch->submitted_list, &pl330->desc_pool);
-	list_splice_tail_init(&pch->work_list, &pl330->desc_pool);
-	list_splice_tail_init(&pch->completed_list, &pl330->desc_pool);
+	put_desc_list(pl330, &pch->submitted_list);
+	put_desc_list(pl330, &pch->work_list);
+	put_desc_list(pl330, &pch->completed_list);
 	spin_unlock_irqrestore(&pch->lock, flags);
 	pm_runtime_mark_last_busy(pl330->ddma.dev);
 	if (power_down)
@@ -2674,7 +2754,7 @@ static void pl330_free_chan_resources(struct dma_chan *chan)
 	pch->thread = NULL;
 
 	if (pch->cyclic)
-		list_splice_tail_init(&pch->work_list, &pch->dmac->desc_pool);
+		put_desc_list(pl330, &pch->work_list);
 
 	spin_unlock_irqrestore(&pl330->lock, flags);
 	pm_runtime_mark_last_busy(pch->dmac->ddma.dev);
@@ -2848,9 +2928,8 @@ static inline void _init_desc(struct dma_pl330_desc *desc)
 	INIT_LIST_HEAD(&desc->node);
 }
 
-/* Returns the number of descriptors added to the DMAC pool */
-static int add_desc(struct list_head *pool, spinlock_t *lock,
-		    gfp_t flg, int count)
+/* Returns the number of descriptors added to the pool */
+static int add_desc(struct pl330_desc_pool *pool, gfp_t flg, int count)
 {
 	struct dma_pl330_desc *desc;
 	unsigned long flags;
@@ -2860,28 +2939,27 @@ static int add_desc(struct list_head *pool, spinlock_t *lock,
 	if (!desc)
 		return 0;
 
-	spin_lock_irqsave(lock, flags);
+	spin_lock_irqsave(&pool->lock, flags);
 
 	for (i = 0; i < count; i++) {
 		_init_desc(&desc[i]);
-		list_add_tail(&desc[i].node, pool);
+		list_add_tail(&desc[i].node, &pool->list);
 	}
 
-	spin_unlock_irqrestore(lock, flags);
+	spin_unlock_irqrestore(&pool->lock, flags);
 
 	return count;
 }
 
-static struct dma_pl330_desc *pluck_desc(struct list_head *pool,
-					 spinlock_t *lock)
+static struct dma_pl330_desc *pluck_desc(struct pl330_desc_pool *pool)
 {
 	struct dma_pl330_desc *desc = NULL;
 	unsigned long flags;
 
-	spin_lock_irqsave(lock, flags);
+	spin_lock_irqsave(&pool->lock, flags);
 
-	if (!list_empty(pool)) {
-		desc = list_entry(pool->next,
+	if (!list_empty(&pool->list)) {
+		desc = list_entry(pool->list.next,
 				struct dma_pl330_desc, node);
 
 		list_del_init(&desc->node);
@@ -2890,30 +2968,84 @@ static struct dma_pl330_desc *pluck_desc(struct list_head *pool,
 		desc->txd.callback = NULL;
 	}
 
-	spin_unlock_irqrestore(lock, flags);
+	spin_unlock_irqrestore(&pool->lock, flags);
 
 	return desc;
 }
 
+/* Refill this CPU's pool with the free list of some other CPU */
+static struct dma_pl330_desc *steal_desc(struct pl330_dmac *pl330)
+{
+	struct pl330_desc_pool *local = raw_cpu_ptr(pl330->desc_pool);
+	struct pl330_desc_pool *pool;
+	unsigned long flags;
+	LIST_HEAD(batch);
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pool = per_cpu_ptr(pl330->desc_pool, cpu);
+		if (pool == local)
+			continue;
+
+		spin_lock_irqsave(&pool->lock, flags);
+		list_splice_init(&pool->list, &batch);
+		spin_unlock_irqrestore(&pool->lock, flags);
+
+		if (!list_empty(&batch))
+			break;
+	}
+
+	if (list_empty(&batch))
+		return NULL;
+
+	spin_lock_irqsave(&local->lock, flags);
+	list_splice_tail(&batch, &local->list);
+	spin_unlock_irqrestore(&local->lock, flags);
+
+	return pluck_desc(local);
+}
+
+static void put_desc(struct pl330_dmac *pl330, struct dma_pl330_desc *desc)
+{
+	struct pl330_desc_pool *pool = raw_cpu_ptr(pl330->desc_pool);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	list_move_tail(&desc->node, &pool->list);
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+
+static void put_desc_list(struct pl330_dmac *pl330, struct list_head *list)
+{
+	struct pl330_desc_pool *pool = raw_cpu_ptr(pl330->desc_pool);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pool->lock, flags);
+	list_splice_tail_init(list, &pool->list);
+	spin_unlock_irqrestore(&pool->lock, flags);
+}
+
 static struct dma_pl330_desc *pl330_get_desc(struct dma_pl330_chan *pch)
 {
 	struct pl330_dmac *pl330 = pch->dmac;
 	u8 *peri_id = pch->chan.private;
 	struct dma_pl330_desc *desc;
 
-	/* Pluck one desc from the pool of DMAC */
-	desc = pluck_desc(&pl330->desc_pool, &pl330->pool_lock);
+	/* Pluck one desc from this CPU's pool, else from another CPU's */
+	desc = pluck_desc(raw_cpu_ptr(pl330->desc_pool));
+	if (!desc)
+		desc = steal_desc(pl330);
 
-	/* If the DMAC pool is empty, alloc new */
+	/* If all the pools are empty, alloc new */
 	if (!desc) {
-		static DEFINE_SPINLOCK(lock);
-		LIST_HEAD(pool);
+		struct pl330_desc_pool *pool = raw_cpu_ptr(pl330->desc_pool);
 
-		if (!add_desc(&pool, &lock, GFP_ATOMIC, 1))
+		if (!add_desc(pool, GFP_ATOMIC, 1))
 			return NULL;
 
-		desc = pluck_desc(&pool, &lock);
-		WARN_ON(!desc || !list_empty(&pool));
+		desc = pluck_desc(pool);
+		if (!desc)
+			return NULL;
 	}
 
 	/* Initialize the descriptor */
@@ -3014,6 +3146,7 @@ struct dma_async_tx_descriptor *__pl330_prep_dma_cyclic(struct dma_chan *chan,
 	for (i = 0; i < len / period_len; i++) {
 		desc = pl330_get_desc(pch);
 		if (!desc) {
+			struct pl330_desc_pool *pool;
 			unsigned long iflags;
 
 			dev_err(pch->dmac->ddma.dev, "%s:%d Unable to fetch desc\n",
@@ -3022,17 +3155,18 @@ struct dma_async_tx_descriptor *__pl330_prep_dma_cyclic(struct dma_chan *chan,
 			if (!first)
 				return NULL;
 
-			spin_lock_irqsave(&pl330->pool_lock, iflags);
+			pool = raw_cpu_ptr(pl330->desc_pool);
+			spin_lock_irqsave(&pool->lock, iflags);
 
 			while (!list_empty(&first->node)) {
 				desc = list_entry(first->node.next,
 						struct dma_pl330_desc, node);
-				list_move_tail(&desc->node, &pl330->desc_pool);
+				list_move_tail(&desc->node, &pool->list);
 			}
 
-			list_move_tail(&first->node, &pl330->desc_pool);
+			list_move_tail(&first->node, &pool->list);
 
-			spin_unlock_irqrestore(&pl330->pool_lock, iflags);
+			spin_unlock_irqrestore(&pool->lock, iflags);
 
 			return NULL;
 		}
@@ -3144,23 +3278,25 @@ pl330_prep_dma_memcpy(struct dma_chan *chan, dma_addr_t dst,
 static void __pl330_giveback_desc(struct pl330_dmac *pl330,
 				  struct dma_pl330_desc *first)
 {
+	struct pl330_desc_pool *pool;
 	unsigned long flags;
 	struct dma_pl330_desc *desc;
 
 	if (!first)
 		return;
 
-	spin_lock_irqsave(&pl330->pool_lock, flags);
+	pool = raw_cpu_ptr(pl330->desc_pool);
+	spin_lock_irqsave(&pool->lock, flags);
 
 	while (!list_empty(&first->node)) {
 		desc = list_entry(first->node.next,
 				struct dma_pl330_desc, node);
-		list_move_tail(&desc->node, &pl330->desc_pool);
+		list_move_tail(&desc->node, &pool->list);
 	}
 
-	list_move_tail(&first->node, &pl330->desc_pool);
+	list_move_tail(&first->node, &pool->list);
 
-	spin_unlock_irqrestore(&pl330->pool_lock, flags);
+	spin_unlock_irqrestore(&pool->lock, flags);
 }
 
 static struct dma_async_tx_descriptor *
@@ -3455,15 +3591,25 @@ pl330_probe(struct amba_device *adev, const struct amba_id *id)
 	pcfg = &pl330->pcfg;
 
 	pcfg->periph_id = adev->periphid;
+
+	pl330->desc_pool = devm_alloc_percpu(&adev->dev,
+					     struct pl330_desc_pool);
+	if (!pl330->desc_pool)
+		return -ENOMEM;
+
+	for_each_possible_cpu(i) {
+		struct pl330_desc_pool *pool = per_cpu_ptr(pl330->desc_pool, i);
+
+		INIT_LIST_HEAD(&pool->list);
+		spin_lock_init(&pool->lock);
+	}
+
 	ret = pl330_add(pl330);
 	if (ret)
 		return ret;
 
-	INIT_LIST_HEAD(&pl330->desc_pool);
-	spin_lock_init(&pl330->pool_lock);
-
 	/* Create a descriptor pool of default size */
-	if (!add_desc(&pl330->desc_pool, &pl330->pool_lock,
+	if (!add_desc(raw_cpu_ptr(pl330->desc_pool),
 		      GFP_KERNEL, NR_DEFAULT_DESC))
 		dev_warn(&adev->dev, "unable to allocate desc\n");
 
@@ -10,9 +10,15 @@
 #ifndef _EXYNOS_PCIE_IOMMU_EXP_H_
 #define _EXYNOS_PCIE_IOMMU_EXP_H_
 
+struct scatterlist;
+
 int pcie_iommu_map(unsigned long iova, phys_addr_t paddr, size_t size,
 		   int prot, int hsi_block_num);
 size_t pcie_iommu_unmap(unsigned long iova, size_t size, int hsi_block_num);
+int pcie_iommu_map_sg(struct scatterlist *sgl, int nents, int prot,
+		      int hsi_block_num);
+size_t pcie_iommu_unmap_sg(struct scatterlist *sgl, int nents,
+			   int hsi_block_num);
 
 void pcie_sysmmu_set_use_iocc(int hsi_block_num);
 void pcie_sysmmu_enable(int hsi_block_num);
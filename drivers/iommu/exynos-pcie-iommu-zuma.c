@@ -1726,6 +1726,211 @@ end_unmap:
 }
 EXPORT_SYMBOL_GPL(pcie_iommu_unmap);
 
+/* Unmap one 4KB aligned run. Must be called with domain->pgtablelock held. */
+static size_t __pcie_iommu_unmap_run(unsigned long iova, size_t size,
+				     struct exynos_iommu_domain *domain,
+				     int hsi_block_num)
+{
+	size_t unmapped_page, unmapped = 0;
+
+	if (g_sysmmu_drvdata[hsi_block_num]->use_map_once && size < SZ_64K) {
+		unmapped = exynos_iommu_unmap_once(iova, size, domain, hsi_block_num);
+		if (unmapped == size)
+			return unmapped;
+		unmapped = 0;
+	}
+
+	while (unmapped < size) {
+		size_t pgsize = iommu_pgsize(iova, size - unmapped, domain);
+
+		if (!pgsize)
+			break;
+
+		alloc_counter--;
+		unmapped_page = exynos_iommu_unmap(iova, pgsize, domain);
+#if IS_ENABLED(CONFIG_PCIE_IOMMU_HISTORY_LOG)
+		add_history_buff(&pcie_unmap_history, iova, iova, size, size);
+#endif
+		if (!unmapped_page)
+			break;
+
+		iova += unmapped_page;
+		unmapped += unmapped_page;
+	}
+
+	return unmapped;
+}
+
+/*
+ * Map one 4KB aligned, physically contiguous run with the largest page
+ * sizes possible. Must be called with domain->pgtablelock held. A run that
+ * fails part way is unrolled before returning.
+ */
+static int __pcie_iommu_map_run(unsigned long iova, phys_addr_t paddr,
+				size_t size, int prot,
+				struct exynos_iommu_domain *domain,
+				int hsi_block_num)
+{
+	unsigned long orig_iova = iova;
+	phys_addr_t __maybe_unused orig_paddr = paddr;
+	size_t orig_size = size;
+	int ret = 0;
+
+#ifdef ENABLE_DRAM_REGION_VALIDATION
+	if (check_memory_validation(paddr) != 0) {
+		pr_warn("WARN - Unexpected address request : 0x%pap\n", &paddr);
+		return -EINVAL;
+	}
+#endif
+
+	if (g_sysmmu_drvdata[hsi_block_num]->use_map_once && size < SZ_64K) {
+		if (!exynos_iommu_map_once(iova, paddr, size, prot, domain,
+					   hsi_block_num))
+			return 0;
+	}
+
+	while (size) {
+		size_t pgsize = iommu_pgsize(iova | paddr, size, domain);
+
+		if (!pgsize) {
+			ret = -EINVAL;
+			break;
+		}
+
+		alloc_counter++;
+		if (alloc_counter > max_req_cnt)
+			max_req_cnt = alloc_counter;
+		ret = exynos_iommu_map(iova, paddr, pgsize, prot, domain, hsi_block_num);
+#if IS_ENABLED(CONFIG_PCIE_IOMMU_HISTORY_LOG)
+		add_history_buff(&pcie_map_history, paddr, orig_paddr,
+				 orig_size, orig_size);
+#endif
+		if (ret)
+			break;
+
+		iova += pgsize;
+		paddr += pgsize;
+		size -= pgsize;
+	}
+
+	if (ret && orig_size != size)
+		__pcie_iommu_unmap_run(orig_iova, orig_size - size, domain,
+				       hsi_block_num);
+
+	return ret;
+}
+
+/*
+ * Return the next run of 4KB pages covered by IOVA contiguous segments
+ * starting at @sg, and the segment following the run. The SysMMU is used as
+ * a 1:1 map, so IOVA contiguous segments are also physically contiguous.
+ */
+static struct scatterlist *pcie_iommu_sg_run(struct scatterlist *sg,
+					     int *nents, unsigned long *iova,
+					     size_t *size)
+{
+	unsigned long start, end;
+
+	start = sg_dma_address(sg) & ~SYSMMU_4KB_MASK;
+	end = ALIGN(sg_dma_address(sg) + sg_dma_len(sg), SZ_4K);
+	sg = sg_next(sg);
+	(*nents)--;
+
+	while (*nents && sg) {
+		if ((sg_dma_address(sg) & ~SYSMMU_4KB_MASK) != end)
+			break;
+		end = ALIGN(sg_dma_address(sg) + sg_dma_len(sg), SZ_4K);
+		sg = sg_next(sg);
+		(*nents)--;
+	}
+
+	*iova = start;
+	*size = end - start;
+
+	return sg;
+}
+
+int pcie_iommu_map_sg(struct scatterlist *sgl, int nents, int prot,
+		      int hsi_block_num)
+{
+	struct exynos_iommu_domain *domain =
+		g_sysmmu_drvdata[hsi_block_num]->domain;
+	int pcie_vid = g_sysmmu_drvdata[hsi_block_num]->pcie_vid;
+	struct scatterlist *sg = sgl, *run = sgl;
+	unsigned long iova, start = ULONG_MAX, end = 0;
+	unsigned long flags;
+	size_t size;
+	int left = nents;
+	int ret = 0;
+
+	spin_lock_irqsave(&domain->pgtablelock, flags);
+
+	while (left > 0 && sg) {
+		run = sg;
+		sg = pcie_iommu_sg_run(sg, &left, &iova, &size);
+
+		start = min(start, iova);
+		end = max(end, iova + size);
+
+		ret = __pcie_iommu_map_run(iova, iova, size, prot, domain,
+					   hsi_block_num);
+		if (ret)
+			break;
+	}
+
+	/* unroll the runs mapped before the failing one */
+	if (ret) {
+		pr_err("PCIe SysMMU SG mapping Error!\n");
+		sg = sgl;
+		left = nents;
+		while (sg != run) {
+			sg = pcie_iommu_sg_run(sg, &left, &iova, &size);
+			__pcie_iommu_unmap_run(iova, size, domain, hsi_block_num);
+		}
+	}
+
+	if (start < end && !g_sysmmu_drvdata[hsi_block_num]->ignore_tlb_inval)
+		exynos_sysmmu_tlb_invalidate(start, end - start, pcie_vid,
+					     hsi_block_num);
+	spin_unlock_irqrestore(&domain->pgtablelock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(pcie_iommu_map_sg);
+
+size_t pcie_iommu_unmap_sg(struct scatterlist *sgl, int nents,
+			   int hsi_block_num)
+{
+	struct exynos_iommu_domain *domain =
+		g_sysmmu_drvdata[hsi_block_num]->domain;
+	int pcie_vid = g_sysmmu_drvdata[hsi_block_num]->pcie_vid;
+	struct scatterlist *sg = sgl;
+	unsigned long iova, start = ULONG_MAX, end = 0;
+	unsigned long flags;
+	size_t size, unmapped = 0;
+	int left = nents;
+
+	spin_lock_irqsave(&domain->pgtablelock, flags);
+
+	while (left > 0 && sg) {
+		sg = pcie_iommu_sg_run(sg, &left, &iova, &size);
+
+		start = min(start, iova);
+		end = max(end, iova + size);
+
+		unmapped += __pcie_iommu_unmap_run(iova, size, domain,
+						   hsi_block_num);
+	}
+
+	if (start < end && !g_sysmmu_drvdata[hsi_block_num]->ignore_tlb_inval)
+		exynos_sysmmu_tlb_invalidate(start, end - start, pcie_vid,
+					     hsi_block_num);
+	spin_unlock_irqrestore(&domain->pgtablelock, flags);
+
+	return unmapped;
+}
+EXPORT_SYMBOL_GPL(pcie_iommu_unmap_sg);
+
 static int __init sysmmu_parse_dt(struct device *sysmmu,
 				  struct sysmmu_drvdata *drvdata)
 {
@@ -41,6 +41,14 @@ static void __iova_insert_rbtree(struct rb_root *root, struct iova *iova, struct
 	rb_insert_color(&iova->node, root);
 }
 
+/*
+ * The walk is linear in the number of allocated ranges. A size-ordered index
+ * of free gaps cannot be kept exact from here: the rbtree and struct iova
+ * belong to the IOVA core, and this module only sees allocations through
+ * android_rvh_iommu_alloc_insert_iova. Frees erase nodes in the core, and
+ * ranges parked in the per-cpu rcaches are released in batches, both without
+ * a hook to follow them.
+ */
 static int __alloc_and_insert_iova_best_fit(struct iova_domain *iovad, unsigned long size,
 					    unsigned long limit_pfn, struct iova *new,
 					    bool size_aligned)
@@ -603,7 +603,6 @@ static int lv1set_section(struct samsung_sysmmu_domain *domain,
 	}
 
 	*sent = make_sysmmu_pte(paddr, SECT_FLAG, attr);
-	pgtable_flush(sent, sent + 1);
 
 	if (pent_to_free) {
 		struct iommu_iotlb_gather gather = {
@@ -611,6 +610,11 @@ static int lv1set_section(struct samsung_sysmmu_domain *domain,
 			.end = iova + SECT_SIZE - 1,
 		};
 
+		/*
+		 * The stale SLPT must not be reachable by the walker before it
+		 * is freed, so this entry cannot wait for the batched flush.
+		 */
+		pgtable_flush(sent, sent + 1);
 		iommu_iotlb_sync(&domain->domain, &gather);
 		kmem_cache_free(slpt_cache, pent_to_free);
 	}
@@ -646,38 +650,70 @@ static int lv2set_page(sysmmu_pte_t *pent, phys_addr_t paddr,
 	return 0;
 }
 
-static int samsung_sysmmu_map(struct iommu_domain *dom, unsigned long l_iova,
-			      phys_addr_t paddr, size_t size, int prot,
-			      gfp_t unused)
+/*
+ * Install @pgcount pages of @pgsize in one call. New first-level entries are
+ * written back to memory in a single flush per run, while second-level
+ * entries are left to samsung_sysmmu_iotlb_sync_map() which flushes each
+ * touched SLPT once after the whole range has been installed.
+ */
+static int samsung_sysmmu_map_pages(struct iommu_domain *dom,
+				    unsigned long l_iova, phys_addr_t paddr,
+				    size_t pgsize, size_t pgcount, int prot,
+				    gfp_t unused, size_t *mapped)
 {
 	struct samsung_sysmmu_domain *domain = to_sysmmu_domain(dom);
 	sysmmu_iova_t iova = (sysmmu_iova_t)l_iova;
-	atomic_t *lv2entcnt = &domain->lv2entcnt[lv1ent_offset(iova)];
-	sysmmu_pte_t *entry;
-	int ret = -ENOMEM;
+	sysmmu_pte_t *sent, *pent = NULL, *flush_start;
+	int ret = 0;
 
 	/* Do not use IO coherency if iOMMU_PRIV exists */
 	if (!!(prot & IOMMU_PRIV))
 		prot &= ~IOMMU_CACHE;
 
-	entry = section_entry(domain->page_table, iova);
+	sent = section_entry(domain->page_table, iova);
+	flush_start = sent;
 
-	if (size == SECT_SIZE) {
-		ret = lv1set_section(domain, entry, iova, paddr, prot,
-				     lv2entcnt);
-	} else {
-		sysmmu_pte_t *pent;
+	while (pgcount--) {
+		atomic_t *lv2entcnt = &domain->lv2entcnt[lv1ent_offset(iova)];
 
-		pent = alloc_lv2entry(domain, entry, iova, lv2entcnt);
+		if (pgsize == SECT_SIZE) {
+			ret = lv1set_section(domain, sent, iova, paddr, prot,
+					     lv2entcnt);
+			if (ret)
+				break;
+			sent++;
+		} else {
+			if (!pent) {
+				pent = alloc_lv2entry(domain, sent, iova,
+						      lv2entcnt);
+				if (IS_ERR(pent)) {
+					ret = PTR_ERR(pent);
+					break;
+				}
+			}
 
-		if (IS_ERR(pent))
-			ret = PTR_ERR(pent);
-		else
-			ret = lv2set_page(pent, paddr, size, prot, lv2entcnt);
+			ret = lv2set_page(pent, paddr, pgsize, prot, lv2entcnt);
+			if (ret)
+				break;
+
+			pent += pgsize >> SPAGE_ORDER;
+			/* crossed into the next SLPT */
+			if (!((iova + pgsize) & ~SECT_MASK)) {
+				pent = NULL;
+				sent++;
+			}
+		}
+
+		iova += pgsize;
+		paddr += pgsize;
+		*mapped += pgsize;
 	}
 
+	if (pgsize == SECT_SIZE && sent != flush_start)
+		pgtable_flush(flush_start, sent);
+
 	if (ret)
-		pr_err("failed to map %#zx @ %#x, ret:%d\n", size, iova, ret);
+		pr_err("failed to map %#zx @ %#x, ret:%d\n", pgsize, iova, ret);
 
 	return ret;
 }
@@ -1354,7 +1390,7 @@ static struct iommu_ops samsung_sysmmu_ops = {
 		.attach_dev		= samsung_sysmmu_attach_dev,
 		.detach_dev		= samsung_sysmmu_detach_dev,
 		.set_dev_pasid		= samsung_sysmmu_set_dev_pasid,
-		.map			= samsung_sysmmu_map,
+		.map_pages		= samsung_sysmmu_map_pages,
 		.unmap			= samsung_sysmmu_unmap,
 		.unmap_pages		= samsung_sysmmu_unmap_pages,
 		.flush_iotlb_all	= samsung_sysmmu_flush_iotlb_all,
@@ -479,6 +479,17 @@ static void __mfc_core_set_slc_option(struct mfc_core *core, struct mfc_ctx *ctx
 	}
 }
 
+/* Reprogram the decoder AXI attributes after the SLC option changed */
+void mfc_core_cmd_update_slc_option(struct mfc_core *core, struct mfc_ctx *ctx)
+{
+	MFC_CORE_WRITEL(0, MFC_REG_D_AXI_WR_ATTR0_SLC);
+	MFC_CORE_WRITEL(0, MFC_REG_D_AXI_WR_ATTR1_SLC);
+	MFC_CORE_WRITEL(0, MFC_REG_D_AXI_RD_ATTR0_SLC);
+	MFC_CORE_WRITEL(0, MFC_REG_D_AXI_RD_ATTR1_SLC);
+
+	__mfc_core_set_slc_option(core, ctx);
+}
+
 int mfc_core_cmd_dec_init_buffers(struct mfc_core *core, struct mfc_ctx *ctx)
 {
 	struct mfc_dev *dev = core->dev;
@@ -31,6 +31,8 @@ void mfc_core_cmd_cache_flush(struct mfc_core *core);
 void mfc_core_cmd_dec_seq_header(struct mfc_core *core, struct mfc_ctx *ctx);
 int mfc_core_cmd_enc_seq_header(struct mfc_core *core, struct mfc_ctx *ctx);
 
+void mfc_core_cmd_update_slc_option(struct mfc_core *core, struct mfc_ctx *ctx);
+
 int mfc_core_cmd_dec_init_buffers(struct mfc_core *core, struct mfc_ctx *ctx);
 int mfc_core_cmd_enc_init_buffers(struct mfc_core *core, struct mfc_ctx *ctx);
 
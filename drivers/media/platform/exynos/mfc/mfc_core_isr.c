@@ -1807,6 +1807,12 @@ irqreturn_t mfc_core_top_half_irq(int irq, void *priv)
 	core->last_int = reason;
 	core->last_int_time = ktime_to_timespec64(ktime_get());
 
+	if ((reason == MFC_REG_R2H_CMD_FRAME_DONE_RET) && core->has_slc &&
+			core->slc_on_status)
+		mfc_slc_policy_sample(core, ctx,
+				timespec64_to_ns(&core->last_int_time) -
+				timespec64_to_ns(&core->last_cmd_time));
+
 	if ((reason == MFC_REG_R2H_CMD_SEQ_DONE_RET) ||
 			(reason == MFC_REG_R2H_CMD_INIT_BUFFERS_RET) ||
 			(reason == MFC_REG_R2H_CMD_FRAME_DONE_RET) ||
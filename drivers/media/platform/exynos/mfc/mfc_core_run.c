@@ -23,6 +23,7 @@
 #include "mfc_queue.h"
 #include "mfc_utils.h"
 #include "mfc_mem.h"
+#include "mfc_slc.h"
 
 /* Initialize hardware */
 int mfc_core_run_init_hw(struct mfc_core *core, int is_drm)
@@ -393,6 +394,9 @@ int mfc_core_run_dec_frame(struct mfc_core *core, struct mfc_ctx *ctx)
 
 	mfc_core_set_dynamic_dpb(core, ctx, dst_mb);
 
+	if (core->has_slc && core->slc_on_status && mfc_slc_policy_apply(core, ctx))
+		mfc_core_cmd_update_slc_option(core, ctx);
+
 	mfc_clean_core_ctx_int_flags(core_ctx);
 
 	last_frame = __mfc_check_last_frame(core_ctx, src_mb);
@@ -76,6 +76,7 @@
 
 /* SLC */
 #define MFC_MAX_SLC_PARTITIONS		3
+#define MFC_SLC_POLICY_MAX		4
 
 /* OTF */
 #define HWFC_MAX_BUF			10
@@ -1329,6 +1330,37 @@ struct dump_info {
 	u64             size;
 };
 
+/**
+ * struct mfc_slc_policy - feedback driven SLC option selection
+ * @enable: policy is running for the current stream
+ * @trial: candidates are being measured one after another, once per
+ *	stream start, instance count change or MFC clock change
+ * @tried: number of candidates measured in the current trial
+ * @cand: candidate option currently programmed
+ * @settled: option chosen by the last trial
+ * @pending: option to program before the next frame, -1 if none
+ * @warmup: frames left to skip after the option was programmed
+ * @nr_frames: frames sampled in the current window
+ * @nr_inst: number of instances the trial was started for
+ * @freq: MFC clock in kHz the trial is measured at
+ * @sum: sum of hardware time per macroblock in ps in the current window
+ * @avg: average hardware time per macroblock in ps of each candidate
+ */
+struct mfc_slc_policy {
+	int enable;
+	int trial;
+	int tried;
+	int cand;
+	int settled;
+	int pending;
+	int warmup;
+	int nr_frames;
+	int nr_inst;
+	int freq;
+	u64 sum;
+	u64 avg[MFC_SLC_POLICY_MAX];
+};
+
 struct mfc_core {
 	struct device		*device;
 	struct iommu_domain	*domain;
@@ -1368,6 +1400,9 @@ struct mfc_core {
 
 	/* current slc option be used */
 	int			curr_slc_option;
+
+	/* decoder SLC option picked from measured frame time */
+	struct mfc_slc_policy	slc_policy;
 #endif
 
 	struct mfc_variant	*variant;
@@ -2041,6 +2076,19 @@ struct mfc_bitrate {
 	int bytesused;
 };
 
+/*
+ * DPB mapping kept alive across queue/release, keyed by dma_buf.
+ * The entry owns one dma_buf reference and the attachment.
+ */
+struct mfc_iovmm_cache {
+	struct list_head list;
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	dma_addr_t addr;
+	int used;
+};
+
 struct dpb_table {
 	dma_addr_t addr[MFC_MAX_PLANES];
 	phys_addr_t paddr;
@@ -2053,6 +2101,7 @@ struct dpb_table {
 	struct dma_buf *dmabufs[MFC_MAX_PLANES];
 	struct dma_buf_attachment *attach[MFC_MAX_PLANES];
 	struct sg_table *sgt[MFC_MAX_PLANES];
+	struct mfc_iovmm_cache *cache[MFC_MAX_PLANES];
 };
 
 struct disp_drc_info {
@@ -2130,6 +2179,9 @@ struct mfc_dec {
 	int refcnt;
 	int last_dpb_max_index;
 	struct mfc_user_shared_handle sh_handle_dpb;
+	/* LRU of DPB mappings, most recently used first */
+	struct list_head iovmm_cache;
+	int nr_iovmm_cache;
 
 	/* for HDR10+ */
 	struct mfc_user_shared_handle sh_handle_hdr;
@@ -32,6 +32,7 @@ extern unsigned int llc_disable;
 extern unsigned int slc_disable;
 extern unsigned int slc_option;
 extern unsigned int slc_partial_height_ratio;
+extern unsigned int slc_policy_disable;
 extern unsigned int perf_boost_mode;
 extern unsigned int drm_predict_disable;
 extern unsigned int reg_test;
@@ -331,6 +331,88 @@ err_get_daddr:
 }
 #endif
 
+static void __mfc_iovmm_cache_release(struct mfc_ctx *ctx, struct mfc_iovmm_cache *entry)
+{
+	struct mfc_dec *dec = ctx->dec_priv;
+
+#if IS_ENABLED(CONFIG_MFC_USE_DMA_SKIP_LAZY_UNMAP)
+	if (ctx->dev->skip_lazy_unmap || ctx->skip_lazy_unmap)
+		entry->attach->dma_map_attrs |= DMA_ATTR_SKIP_LAZY_UNMAP;
+#endif
+	mfc_debug(2, "[IOVMM] release cached addr: %#llx\n", entry->addr);
+
+	dma_buf_unmap_attachment(entry->attach, entry->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(entry->dmabuf, entry->attach);
+	dma_buf_put(entry->dmabuf);
+	list_del(&entry->list);
+	dec->nr_iovmm_cache--;
+	kfree(entry);
+}
+
+/* Drop the least recently used idle mappings until at most @limit remain */
+static void __mfc_iovmm_cache_shrink(struct mfc_ctx *ctx, int limit)
+{
+	struct mfc_dec *dec = ctx->dec_priv;
+	struct mfc_iovmm_cache *entry, *tmp;
+
+	list_for_each_entry_safe_reverse(entry, tmp, &dec->iovmm_cache, list) {
+		if (dec->nr_iovmm_cache <= limit)
+			break;
+		if (!entry->used)
+			__mfc_iovmm_cache_release(ctx, entry);
+	}
+}
+
+static int __mfc_iovmm_cache_limit(struct mfc_ctx *ctx)
+{
+	struct mfc_dec *dec = ctx->dec_priv;
+	int nr_dpb = dec->total_dpb_count;
+
+	if (nr_dpb <= 0 || nr_dpb > MFC_MAX_DPBS)
+		nr_dpb = MFC_MAX_DPBS;
+
+	return nr_dpb * ctx->dst_fmt->mem_planes;
+}
+
+static struct mfc_iovmm_cache *__mfc_iovmm_cache_find(struct mfc_ctx *ctx,
+		struct dma_buf *dmabuf)
+{
+	struct mfc_dec *dec = ctx->dec_priv;
+	struct mfc_iovmm_cache *entry;
+
+	list_for_each_entry(entry, &dec->iovmm_cache, list) {
+		if (entry->dmabuf == dmabuf) {
+			list_move(&entry->list, &dec->iovmm_cache);
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/* Hand over the plane mapping to the cache, it stays valid after put */
+static void __mfc_iovmm_cache_add(struct mfc_ctx *ctx, struct dpb_table *dpb,
+		int index, int plane)
+{
+	struct mfc_dec *dec = ctx->dec_priv;
+	struct mfc_iovmm_cache *entry;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return;
+
+	entry->dmabuf = dpb[index].dmabufs[plane];
+	entry->attach = dpb[index].attach[plane];
+	entry->sgt = dpb[index].sgt[plane];
+	entry->addr = dpb[index].addr[plane];
+	entry->used = 1;
+	list_add(&entry->list, &dec->iovmm_cache);
+	dec->nr_iovmm_cache++;
+	dpb[index].cache[plane] = entry;
+
+	__mfc_iovmm_cache_shrink(ctx, __mfc_iovmm_cache_limit(ctx));
+}
+
 void mfc_put_iovmm(struct mfc_ctx *ctx, struct dpb_table *dpb, int num_planes, int index)
 {
 	struct mfc_dev *dev = ctx->dev;
@@ -340,6 +422,15 @@ void mfc_put_iovmm(struct mfc_ctx *ctx, struct dpb_table *dpb, int num_planes, i
 			index, dpb[index].fd[0], dpb[index].addr[0], dpb[index].mapcnt);
 
 	for (i = 0; i < num_planes; i++) {
+		if (dpb[index].cache[i]) {
+			/* keep the mapping for the next time this buffer is queued */
+			dpb[index].cache[i]->used--;
+			mfc_debug(2, "[IOVMM] index %d buf[%d] fd: %d addr: %#llx (cached)\n",
+					index, i, dpb[index].fd[i], dpb[index].addr[i]);
+			dpb[index].cache[i] = NULL;
+			goto clear_plane;
+		}
+
 #if IS_ENABLED(CONFIG_MFC_USE_DMA_SKIP_LAZY_UNMAP)
 		if (dpb[index].attach[i] && (dev->skip_lazy_unmap || ctx->skip_lazy_unmap)) {
 			dpb[index].attach[i]->dma_map_attrs |= DMA_ATTR_SKIP_LAZY_UNMAP;
@@ -358,6 +449,7 @@ void mfc_put_iovmm(struct mfc_ctx *ctx, struct dpb_table *dpb, int num_planes, i
 		if (dpb[index].dmabufs[i])
 			dma_buf_put(dpb[index].dmabufs[i]);
 
+clear_plane:
 		dpb[index].fd[i] = -1;
 		dpb[index].addr[i] = 0;
 		dpb[index].attach[i] = NULL;
@@ -382,6 +474,7 @@ void mfc_put_iovmm(struct mfc_ctx *ctx, struct dpb_table *dpb, int num_planes, i
 void mfc_get_iovmm(struct mfc_ctx *ctx, struct vb2_buffer *vb, struct dpb_table *dpb)
 {
 	struct mfc_dev *dev = ctx->dev;
+	struct mfc_iovmm_cache *entry;
 	int i, mem_get_count = 0;
 	struct mfc_buf *mfc_buf = vb_to_mfc_buf(vb);
 	int index = mfc_buf->dpb_index;
@@ -407,6 +500,21 @@ void mfc_get_iovmm(struct mfc_ctx *ctx, struct vb2_buffer *vb, struct dpb_table
 			goto err_iovmm;
 		}
 
+		entry = __mfc_iovmm_cache_find(ctx, dpb[index].dmabufs[i]);
+		if (entry) {
+			/* the cache already holds a reference */
+			dma_buf_put(dpb[index].dmabufs[i]);
+			entry->used++;
+			dpb[index].dmabufs[i] = entry->dmabuf;
+			dpb[index].attach[i] = entry->attach;
+			dpb[index].sgt[i] = entry->sgt;
+			dpb[index].addr[i] = entry->addr;
+			dpb[index].cache[i] = entry;
+			mfc_debug(2, "[IOVMM] index %d buf[%d] fd: %d addr: %#llx (cached)\n",
+					index, i, dpb[index].fd[i], dpb[index].addr[i]);
+			continue;
+		}
+
 		dpb[index].attach[i] = dma_buf_attach(dpb[index].dmabufs[i], dev->device);
 		if (IS_ERR(dpb[index].attach[i])) {
 			mfc_ctx_err("[IOVMM] Failed to get dma_buf_attach (err %ld)\n",
@@ -434,6 +542,8 @@ void mfc_get_iovmm(struct mfc_ctx *ctx, struct vb2_buffer *vb, struct dpb_table
 
 		mfc_debug(2, "[IOVMM] index %d buf[%d] fd: %d addr: %#llx\n",
 				index, i, dpb[index].fd[i], dpb[index].addr[i]);
+
+		__mfc_iovmm_cache_add(ctx, dpb, index, i);
 	}
 
 	dpb[index].paddr = page_to_phys(sg_page(dpb[index].sgt[0]->sgl));
@@ -464,11 +574,15 @@ void mfc_init_dpb_table(struct mfc_ctx *ctx)
 			dec->dpb[index].addr[plane] = 0;
 			dec->dpb[index].attach[plane] = NULL;
 			dec->dpb[index].dmabufs[plane] = NULL;
+			dec->dpb[index].cache[plane] = NULL;
 		}
 		dec->dpb[index].new_fd = -1;
 		dec->dpb[index].mapcnt = 0;
 		dec->dpb[index].queued = 0;
 	}
+
+	INIT_LIST_HEAD(&dec->iovmm_cache);
+	dec->nr_iovmm_cache = 0;
 }
 
 void mfc_cleanup_iovmm(struct mfc_ctx *ctx)
@@ -496,6 +610,11 @@ void mfc_cleanup_iovmm(struct mfc_ctx *ctx)
 		}
 	}
 
+	__mfc_iovmm_cache_shrink(ctx, 0);
+	if (dec->nr_iovmm_cache)
+		mfc_ctx_err("[IOVMM] %d cached mappings still in use\n",
+				dec->nr_iovmm_cache);
+
 	mutex_unlock(&dec->dpb_mutex);
 }
 
@@ -526,6 +645,9 @@ void mfc_cleanup_iovmm_except_used(struct mfc_ctx *ctx)
 		}
 	}
 
+	/* buffers are usually reallocated after this, drop idle mappings */
+	__mfc_iovmm_cache_shrink(ctx, 0);
+
 	mutex_unlock(&dec->dpb_mutex);
 }
 
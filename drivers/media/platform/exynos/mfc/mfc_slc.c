@@ -11,6 +11,13 @@
 #include "mfc_core_reg_api.h"
 
 #if IS_ENABLED(CONFIG_SLC_PARTITION_MANAGER)
+/* frames skipped after an option change until the cache is warm */
+#define MFC_SLC_POLICY_WARMUP		4
+/* frames averaged for one measurement */
+#define MFC_SLC_POLICY_WINDOW		32
+/* a candidate must be faster by this percent to replace the settled one */
+#define MFC_SLC_POLICY_HYSTERESIS	5
+
 void mfc_slc_enable(struct mfc_core *core)
 {
 	int i;
@@ -193,6 +200,93 @@ done:
 	mfc_core_debug_leave();
 }
 
+static int __mfc_slc_policy_option(struct mfc_ctx *ctx, int cfg)
+{
+	switch (cfg) {
+	case MFC_SLC_POLICY_REF_R:
+		return (MFC_SLC_OPTION_INTERNAL | MFC_SLC_OPTION_REF_PXL_R);
+	case MFC_SLC_POLICY_DPB_W:
+		if (UNDER_FHD_RES(ctx))
+			return (MFC_SLC_OPTION_INTERNAL |
+				MFC_SLC_OPTION_DPB_FULL_W |
+				MFC_SLC_OPTION_DPB_LUMA_W |
+				MFC_SLC_OPTION_DPB_CHROMA_W |
+				MFC_SLC_OPTION_REF_PXL_R);
+		return (MFC_SLC_OPTION_INTERNAL |
+			MFC_SLC_OPTION_DPB_PARTIAL_W |
+			MFC_SLC_OPTION_DPB_LUMA_W |
+			MFC_SLC_OPTION_DPB_CHROMA_W |
+			MFC_SLC_OPTION_REF_PXL_R);
+	default:
+		return MFC_SLC_OPTION_INTERNAL;
+	}
+}
+
+/*
+ * The internal buffer partition is 512KB, or 1MB for 4K streams. The
+ * MFC_SLC_POLICY_INTERNAL_1MB candidate tries the larger one on any stream.
+ */
+static void __mfc_slc_policy_resize(struct mfc_core *core, struct mfc_ctx *ctx,
+		int cfg)
+{
+	int idx = MFC_SLC_PARTITION_512KB;
+
+	if ((cfg == MFC_SLC_POLICY_INTERNAL_1MB) || OVER_UHD_RES(ctx))
+		idx = MFC_SLC_PARTITION_1MB;
+
+	if ((core->num_slc_pt <= 1) ||
+			(core->ptid[MFC_SLC_INTERNAL] == PT_PTID_INVALID) ||
+			(core->curr_slc_pt_idx[MFC_SLC_INTERNAL] == idx))
+		return;
+
+	core->ptid[MFC_SLC_INTERNAL] = pt_client_mutate(core->pt_handle,
+			core->curr_slc_pt_idx[MFC_SLC_INTERNAL], idx);
+	if (core->ptid[MFC_SLC_INTERNAL] == PT_PTID_INVALID) {
+		mfc_core_err("[SLC] Resizing SLC partition fail");
+		core->slc_policy.enable = 0;
+		mfc_slc_disable(core);
+		return;
+	}
+
+	mfc_core_debug(2, "[SLC] policy resized internal partition to %d\n", idx);
+	core->curr_slc_pt_idx[MFC_SLC_INTERNAL] = idx;
+}
+
+/* Measure every candidate once, starting from the one programmed now */
+static void __mfc_slc_policy_restart(struct mfc_slc_policy *policy)
+{
+	policy->trial = 1;
+	policy->tried = 0;
+	policy->warmup = MFC_SLC_POLICY_WARMUP;
+	policy->nr_frames = 0;
+	policy->sum = 0;
+}
+
+static void __mfc_slc_policy_init(struct mfc_core *core, struct mfc_ctx *ctx)
+{
+	struct mfc_slc_policy *policy = &core->slc_policy;
+	int cfg;
+
+	memset(policy, 0, sizeof(*policy));
+	policy->pending = MFC_SLC_POLICY_NONE;
+
+	if (slc_option || slc_policy_disable)
+		return;
+
+	/* the static choice is measured first and kept on a tie */
+	cfg = ((ctx->type == MFCINST_DECODER) && (core->num_inst == 1)) ?
+		MFC_SLC_POLICY_DPB_W : MFC_SLC_POLICY_INTERNAL;
+	policy->enable = 1;
+	policy->cand = cfg;
+	policy->settled = cfg;
+	policy->nr_inst = core->num_inst;
+	policy->freq = core->last_mfc_freq;
+	__mfc_slc_policy_restart(policy);
+
+	/* a previous stream may have settled on the 1MB candidate */
+	__mfc_slc_policy_resize(core, ctx, cfg);
+}
+
 void mfc_slc_check_options(struct mfc_core *core, struct mfc_ctx *ctx) {
 	mfc_core_debug_enter();
 	if (core->num_slc_pt >= MFC_MAX_SLC_PARTITIONS) {
@@ -203,26 +297,18 @@ void mfc_slc_check_options(struct mfc_core *core, struct mfc_ctx *ctx) {
 		 * Enable partial reference frame cache when decoder resolution is greater
 		 * than 1080p and the number of instances is 1.
 		 * Otherwise use internal buffer cache only.
+		 * This is only the starting point, mfc_slc_policy_sample() then
+		 * picks the option by measurement while a decoder is running.
 		 */
 		if (slc_option) {
 			core->curr_slc_option = slc_option;
 		} else if ((ctx->type == MFCINST_DECODER) && (core->num_inst == 1)) {
-			if (UNDER_FHD_RES(ctx)) {
-				core->curr_slc_option = (MFC_SLC_OPTION_INTERNAL |
-							MFC_SLC_OPTION_DPB_FULL_W |
-							MFC_SLC_OPTION_DPB_LUMA_W |
-							MFC_SLC_OPTION_DPB_CHROMA_W |
-							MFC_SLC_OPTION_REF_PXL_R);
-			} else {
-				core->curr_slc_option = (MFC_SLC_OPTION_INTERNAL |
-							MFC_SLC_OPTION_DPB_PARTIAL_W |
-							MFC_SLC_OPTION_DPB_LUMA_W |
-							MFC_SLC_OPTION_DPB_CHROMA_W |
-							MFC_SLC_OPTION_REF_PXL_R);
-			}
+			core->curr_slc_option = __mfc_slc_policy_option(ctx,
+							MFC_SLC_POLICY_DPB_W);
 		} else {
 			core->curr_slc_option = MFC_SLC_OPTION_INTERNAL;
 		}
+		__mfc_slc_policy_init(core, ctx);
 	}
 	mfc_core_info("[SLC] Current SLC Option: %d\n", core->curr_slc_option);
 	mfc_core_debug_leave();
@@ -304,4 +390,123 @@ void mfc_slc_enable_more_partitions(struct mfc_core *core, struct mfc_ctx *ctx)
 
 	mfc_core_debug_leave();
 }
+
+static void __mfc_slc_policy_next(struct mfc_core *core, u64 avg)
+{
+	struct mfc_slc_policy *policy = &core->slc_policy;
+	int i, best;
+
+	policy->avg[policy->cand] = avg;
+
+	if (++policy->tried < MFC_SLC_POLICY_MAX) {
+		policy->pending = (policy->cand + 1) % MFC_SLC_POLICY_MAX;
+		return;
+	}
+
+	best = policy->settled;
+	for (i = 0; i < MFC_SLC_POLICY_MAX; i++)
+		if (policy->avg[i] < policy->avg[best])
+			best = i;
+
+	if ((best != policy->settled) &&
+			(policy->avg[best] * 100 <
+			 policy->avg[policy->settled] * (100 - MFC_SLC_POLICY_HYSTERESIS))) {
+		mfc_core_debug(2, "[SLC] policy %d -> %d (%llu -> %llu ps/MB)\n",
+				policy->settled, best,
+				policy->avg[policy->settled], policy->avg[best]);
+		policy->settled = best;
+	}
+
+	/* kept until the stream or the number of instances changes */
+	policy->trial = 0;
+	if (policy->cand != policy->settled)
+		policy->pending = policy->settled;
+}
+
+/*
+ * Called from the interrupt handler with the hardware time of a decoded
+ * frame. Each candidate option is measured once over a window of frames
+ * and the fastest one is kept, a change is programmed by
+ * mfc_slc_policy_apply(). Decode is bound by reference and DPB traffic, so
+ * the frame time drops with the DRAM reads the SLC absorbs and stands in
+ * for MFC read bytes. The time is scaled per macroblock so that frames of
+ * concurrent instances can share a window, and a trial only compares
+ * candidates measured at the same MFC clock.
+ */
+void mfc_slc_policy_sample(struct mfc_core *core, struct mfc_ctx *ctx, u64 frame_ns)
+{
+	struct mfc_slc_policy *policy = &core->slc_policy;
+	unsigned int mbs;
+
+	if (!policy->enable || !policy->trial || (ctx->type != MFCINST_DECODER))
+		return;
+	if (policy->pending != MFC_SLC_POLICY_NONE)
+		return;
+
+	if (policy->freq != core->last_mfc_freq) {
+		/* DVFS moved, the candidates measured so far are not comparable */
+		policy->freq = core->last_mfc_freq;
+		__mfc_slc_policy_restart(policy);
+		return;
+	}
+
+	/* the first frames after a partition switch still refill the SLC */
+	if (policy->warmup) {
+		policy->warmup--;
+		return;
+	}
+
+	mbs = DIV_ROUND_UP(ctx->img_width, 16) * DIV_ROUND_UP(ctx->img_height, 16);
+	if (!mbs)
+		return;
+
+	policy->sum += div_u64(frame_ns * 1000, mbs);
+	if (++policy->nr_frames < MFC_SLC_POLICY_WINDOW)
+		return;
+
+	__mfc_slc_policy_next(core, div_u64(policy->sum, MFC_SLC_POLICY_WINDOW));
+	policy->nr_frames = 0;
+	policy->sum = 0;
+}
+
+/*
+ * Called before a decoder frame is issued. Returns 1 when the SLC option
+ * changed and the AXI attributes must be programmed again.
+ */
+int mfc_slc_policy_apply(struct mfc_core *core, struct mfc_ctx *ctx)
+{
+	struct mfc_slc_policy *policy = &core->slc_policy;
+	int cfg;
+
+	if (!policy->enable)
+		return 0;
+
+	if (policy->nr_inst != core->num_inst) {
+		/* an instance closed, the other streams now own the SLC */
+		policy->nr_inst = core->num_inst;
+		policy->pending = MFC_SLC_POLICY_NONE;
+		__mfc_slc_policy_restart(policy);
+	}
+
+	cfg = policy->pending;
+	if (cfg == MFC_SLC_POLICY_NONE)
+		return 0;
+
+	policy->pending = MFC_SLC_POLICY_NONE;
+	policy->cand = cfg;
+	policy->warmup = MFC_SLC_POLICY_WARMUP;
+	policy->nr_frames = 0;
+	policy->sum = 0;
+	__mfc_slc_policy_resize(core, ctx, cfg);
+	if (!policy->enable)
+		return 0;
+
+	core->curr_slc_option = __mfc_slc_policy_option(ctx, cfg);
+	mfc_slc_enable_more_partitions(core, ctx);
+	mfc_core_debug(2, "[SLC] policy applied %d, option: %d\n",
+			cfg, core->curr_slc_option);
+	MFC_TRACE_CORE("[SLC] policy option: %d\n", core->curr_slc_option);
+
+	return 1;
+}
 #endif
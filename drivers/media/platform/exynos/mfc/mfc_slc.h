@@ -75,6 +75,21 @@ enum mfc_slc_option {
 	MFC_SLC_OPTION_REF_PXL_R		= BIT(5),
 };
 
+/**
+ * enum mfc_slc_policy_cfg - The candidates of decoder SLC policy
+ * @MFC_SLC_POLICY_INTERNAL: internal buffers only
+ * @MFC_SLC_POLICY_REF_R: internal buffers and reference pixel read
+ * @MFC_SLC_POLICY_DPB_W: internal buffers, DPB write and reference read
+ * @MFC_SLC_POLICY_INTERNAL_1MB: internal buffers in a 1MB partition
+ */
+enum mfc_slc_policy_cfg {
+	MFC_SLC_POLICY_NONE		= -1,
+	MFC_SLC_POLICY_INTERNAL		= 0,
+	MFC_SLC_POLICY_REF_R		= 1,
+	MFC_SLC_POLICY_DPB_W		= 2,
+	MFC_SLC_POLICY_INTERNAL_1MB	= 3,
+};
+
 void mfc_slc_enable(struct mfc_core *core);
 void mfc_slc_disable(struct mfc_core *core);
 void mfc_slc_flush(struct mfc_core *core, struct mfc_ctx *ctx);
@@ -83,6 +98,8 @@ void mfc_slc_update_partition(struct mfc_core *core, struct mfc_ctx *ctx);
 void mfc_slc_check_options(struct mfc_core *core, struct mfc_ctx *ctx);
 void mfc_slc_disable_particular_partition(struct mfc_core *core, int partition);
 void mfc_slc_enable_more_partitions(struct mfc_core *core, struct mfc_ctx *ctx);
+void mfc_slc_policy_sample(struct mfc_core *core, struct mfc_ctx *ctx, u64 frame_ns);
+int mfc_slc_policy_apply(struct mfc_core *core, struct mfc_ctx *ctx);
 
 void mfc_client_pt_register(struct mfc_core *core);
 void mfc_client_pt_unregister(struct mfc_core *core);
@@ -90,6 +107,8 @@ void mfc_client_pt_unregister(struct mfc_core *core);
 #define mfc_slc_enable(core)	do {} while (0)
 #define mfc_slc_disable(core)	do {} while (0)
 #define mfc_slc_flush(core)	do {} while (0)
+#define mfc_slc_policy_sample(core, ctx, frame_ns)	do {} while (0)
+#define mfc_slc_policy_apply(core, ctx)	0
 
 #define mfc_client_pt_register(core) do {} while (0)
 #define mfc_client_pt_unregister(core) do {} while (0)
@@ -579,6 +579,8 @@ static int exynos_smfc_release(struct file *filp)
 
 	kfree(ctx->quantizer_tables);
 	kfree(ctx->huffman_tables);
+	kfree(ctx->parse_buf);
+	kfree(ctx->tbl_cache);
 
 	kfree(ctx);
 
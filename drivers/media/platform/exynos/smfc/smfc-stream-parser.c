@@ -15,54 +15,120 @@
 
 #include "smfc.h"
 
+/* header bytes copied from a userptr stream at a time */
+#define SMFC_PARSE_CHUNK	SZ_4K
+/* DHT and DQT segments of the previous stream kept for comparison */
+#define SMFC_TBL_CACHE_SIZE	SZ_2K
+
 static bool smfc_alloc_tables(struct smfc_ctx *ctx)
 {
-	int i;
-
 	if (!ctx->quantizer_tables) {
 		ctx->quantizer_tables = kmalloc(sizeof(*ctx->quantizer_tables), GFP_KERNEL);
 		if (!ctx->quantizer_tables)
 			return false;
 	}
-	memset(ctx->quantizer_tables, 0, sizeof(*ctx->quantizer_tables));
-	for (i = 0; i < SMFC_MAX_QTBL_COUNT; i++)
-		ctx->quantizer_tables->compsel[i] = INVALID_QTBLIDX;
 
 	if (!ctx->huffman_tables) {
 		ctx->huffman_tables = kmalloc(sizeof(*ctx->huffman_tables), GFP_KERNEL);
 		if (!ctx->huffman_tables)
 			return false;
 	}
-	memset(ctx->huffman_tables, 0, sizeof(*ctx->huffman_tables));
+
+	if (!ctx->parse_buf) {
+		ctx->parse_buf = kmalloc(SMFC_PARSE_CHUNK, GFP_KERNEL);
+		if (!ctx->parse_buf)
+			return false;
+		ctx->parse_buf_size = SMFC_PARSE_CHUNK;
+	}
+
+	if (!ctx->tbl_cache) {
+		ctx->tbl_cache = kmalloc(SMFC_TBL_CACHE_SIZE, GFP_KERNEL);
+		if (!ctx->tbl_cache)
+			return false;
+		ctx->tbl_cache_len = 0;
+	}
 
 	return true;
 }
 
-union jpeg_hword_t {
-	u16 hword;
-	u8 byte[2];
+static void smfc_reset_tables(struct smfc_ctx *ctx)
+{
+	memset(ctx->quantizer_tables, 0, sizeof(*ctx->quantizer_tables));
+	memset(ctx->huffman_tables, 0, sizeof(*ctx->huffman_tables));
+}
+
+/* per-stream selectors are set by SOF0 and SOS of every stream */
+static void smfc_reset_compsel(struct smfc_ctx *ctx)
+{
+	int i;
+
+	for (i = 0; i < SMFC_MAX_QTBL_COUNT; i++)
+		ctx->quantizer_tables->compsel[i] = INVALID_QTBLIDX;
+	memset(ctx->huffman_tables->compsel, 0,
+	       sizeof(ctx->huffman_tables->compsel));
+}
+
+/*
+ * The stream is either mapped in the kernel (MMAP and DMABUF) or copied
+ * chunk by chunk from the user (USERPTR) into ctx->parse_buf.
+ */
+struct smfc_stream {
+	const u8 *kaddr;
+	unsigned long uaddr;
+	size_t size;
+	size_t buf_pos;
+	size_t buf_len;
 };
 
-static int smfc_get_segment_length(struct smfc_ctx *ctx,
-				   unsigned long addr, u8 marker, u16 *length)
+static const u8 *smfc_stream_get(struct smfc_ctx *ctx, struct smfc_stream *stream,
+				 size_t pos, size_t len)
 {
-	union jpeg_hword_t len;
-	int ret;
+	if (pos > stream->size || len > stream->size - pos)
+		return ERR_PTR(-EINVAL);
 
-	if (IS_ENABLED(CONFIG_CPU_BIG_ENDIAN)) {
-		ret = get_user(len.byte[0], (u16 *)addr++);
-		ret |= get_user(len.byte[1], (u16 *)addr);
-	} else {
-		ret = get_user(len.byte[1], (u16 *)addr++);
-		ret |= get_user(len.byte[0], (u16 *)addr);
+	if (stream->kaddr)
+		return stream->kaddr + pos;
+
+	if (pos >= stream->buf_pos && pos + len <= stream->buf_pos + stream->buf_len)
+		return ctx->parse_buf + (pos - stream->buf_pos);
+
+	if (len > ctx->parse_buf_size) {
+		u8 *buf = krealloc(ctx->parse_buf, len, GFP_KERNEL);
+
+		if (!buf)
+			return ERR_PTR(-ENOMEM);
+		ctx->parse_buf = buf;
+		ctx->parse_buf_size = len;
+	}
+
+	stream->buf_pos = pos;
+	stream->buf_len = min_t(size_t, ctx->parse_buf_size, stream->size - pos);
+	if (copy_from_user(ctx->parse_buf, (void __user *)(stream->uaddr + pos),
+			   stream->buf_len)) {
+		stream->buf_len = 0;
+		return ERR_PTR(-EFAULT);
 	}
-	if (ret) {
+
+	return ctx->parse_buf;
+}
+
+static int smfc_get_segment_length(struct smfc_ctx *ctx, struct smfc_stream *stream,
+				   size_t pos, u8 marker, u16 *length)
+{
+	const u8 *p = smfc_stream_get(ctx, stream, pos, 2);
+
+	if (IS_ERR(p)) {
 		dev_err(ctx->smfc->dev,
 			"Failed to read length 0xFF%02X\n", marker);
-		return -EFAULT;
+		return PTR_ERR(p);
 	}
 
-	*length = len.hword;
+	*length = (p[0] << 8) | p[1];
+	if (*length < 2) {
+		dev_err(ctx->smfc->dev,
+			"Invalid length %u of 0xFF%02X\n", *length, marker);
+		return -EINVAL;
+	}
 
 	return 0;
 }
@@ -92,32 +158,20 @@ unsigned int smfc_get_num_huffval(u8 *hufflen)
 	return num;
 }
 
-static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
+/* @seg points to the length field of the segment and holds @len bytes */
+static int smfc_parse_dht(struct smfc_ctx *ctx, const u8 *seg, u16 len)
 {
-	u8 __user *pcursor = (u8 __user *)*cursor;
-	unsigned long segend;
-	int ret;
-	u16 len;
-
-	ret = smfc_get_segment_length(ctx, *cursor, 0xc4, &len);
-	if (ret)
-		return ret;
-
-	segend = *cursor + len;
-	pcursor += 2;
+	size_t off = 2;
 
 	/* 17 : TcTh, L1...L16 */
-	while (((unsigned long)pcursor) < (segend - 17)) {
+	while (off + 17 < len) {
 		u8 *table;
 		unsigned int num_values;
 		u8 tcth;
 		bool dc;
 
-		ret = get_user(tcth, pcursor++);
-		if (ret) {
-			dev_err(ctx->smfc->dev, "Failed to read TcTh in DHT\n");
-			return ret;
-		} else if (__halfbytes_larger_than(tcth, 1)) {
+		tcth = seg[off++];
+		if (__halfbytes_larger_than(tcth, 1)) {
 			dev_err(ctx->smfc->dev, "Unsupported TcTh %#x in DHT\n", tcth);
 			return -EINVAL;
 		}
@@ -126,13 +180,8 @@ static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
 		dc = (((tcth >> 4) & 0xF) == 0);
 		table = dc ? ctx->huffman_tables->dc[tcth & 1].code
 			   : ctx->huffman_tables->ac[tcth & 1].code;
-		ret = copy_from_user(table, pcursor, SMFC_NUM_HCODE);
-		pcursor += SMFC_NUM_HCODE;
-		if (ret) {
-			dev_err(ctx->smfc->dev,
-				"Failed to read HUFFLEN of %d,%d\n", tcth >> 4, tcth & 1);
-			return ret;
-		}
+		memcpy(table, seg + off, SMFC_NUM_HCODE);
+		off += SMFC_NUM_HCODE;
 
 		num_values = smfc_get_num_huffval(table);
 		if ((dc && num_values > SMFC_NUM_DC_HVAL) ||
@@ -143,90 +192,91 @@ static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
 			return -EINVAL;
 		}
 
-		if (((unsigned long)pcursor + num_values) > segend)
+		if ((off + num_values) > len)
 			break;
 
 		/* HUFFVAL */
 		table = dc ? ctx->huffman_tables->dc[tcth & 1].value
 			   : ctx->huffman_tables->ac[tcth & 1].value;
-		ret = copy_from_user(table, pcursor, num_values);
-		pcursor += (unsigned long)num_values;
-		if (ret) {
-			dev_err(ctx->smfc->dev,
-				"Failed to read huffval of %d,%d\n", tcth >> 4, tcth & 1);
-			return -EINVAL;
-		}
+		memcpy(table, seg + off, num_values);
+		off += num_values;
 	}
 
-	if ((*cursor + len) != (unsigned long)pcursor) {
+	if (off != len) {
 		dev_err(ctx->smfc->dev, "Incorrect DHT length %d\n", len);
 		return -EINVAL;
 	}
 
-	*cursor += len;
-
 	return 0;
 }
 
-static int smfc_parse_dqt(struct smfc_ctx *ctx, unsigned long *cursor)
+/* @seg points to the length field of the segment and holds @len bytes */
+static int smfc_parse_dqt(struct smfc_ctx *ctx, const u8 *seg, u16 len)
 {
-	u8 __user *pcursor = (u8 __user *)*cursor;
-	unsigned long segend;
-	int ret;
-	u16 len;
-
-	ret = smfc_get_segment_length(ctx, *cursor, 0xdb, &len);
-	if (ret)
-		return ret;
+	size_t off = 2;
 
-	segend = *cursor + len;
-	pcursor += 2;
+	while (off < len) {
+		u8 pqtq = seg[off++];
 
-	/* 17 : TcTh, L1...L16 */
-	while ((unsigned long)pcursor < segend) {
-		u8 pqtq;
-
-		ret = get_user(pqtq, pcursor++);
-		if (ret) {
-			dev_err(ctx->smfc->dev, "Failed to read PqTq in DQT\n");
-			return ret;
-		} else if (pqtq >= SMFC_MAX_QTBL_COUNT) {
+		if (pqtq >= SMFC_MAX_QTBL_COUNT) {
 			/* Pq should be 0, Tq should be < 4 */
 			dev_err(ctx->smfc->dev, "Invalid PqTq %02xin DQT\n", pqtq);
 			return -EINVAL;
 		}
 
-		ret = copy_from_user(ctx->quantizer_tables->table[pqtq], pcursor, SMFC_MCU_SIZE);
-		pcursor += (unsigned long)SMFC_MCU_SIZE;
-		if (ret) {
-			dev_err(ctx->smfc->dev, "Failed to read %dth Q-Table\n", pqtq);
-			return ret;
+		if (off + SMFC_MCU_SIZE > len) {
+			dev_err(ctx->smfc->dev, "Incorrect DQT length %d\n", len);
+			return -EINVAL;
 		}
-	}
 
-	*cursor += len;
+		memcpy(ctx->quantizer_tables->table[pqtq], seg + off, SMFC_MCU_SIZE);
+		off += SMFC_MCU_SIZE;
+	}
 
 	return 0;
 }
 
-#define SOF0_LENGTH 17 /* Lf+P+Y+X+Nf+Nf*Comp */
-static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
+static int smfc_parse_table(struct smfc_ctx *ctx, u8 marker, const u8 *seg, u16 len)
 {
-	u8 *pos;
-	int i, ret;
-	u8 sof0[SOF0_LENGTH];
+	return (marker == 0xC4) ? smfc_parse_dht(ctx, seg, len)
+				: smfc_parse_dqt(ctx, seg, len);
+}
 
-	pos = sof0;
+/*
+ * The cache holds the DHT/DQT segments of the last parsed stream, each
+ * prefixed by its marker. Re-parse the first @upto bytes of it into
+ * cleared tables, used when a stream starts differing from the cache.
+ */
+static int smfc_replay_tbl_cache(struct smfc_ctx *ctx, size_t upto)
+{
+	size_t off = 0;
+	int ret;
+
+	smfc_reset_tables(ctx);
+	smfc_reset_compsel(ctx);
+
+	while (off < upto) {
+		const u8 *seg = ctx->tbl_cache + off + 1;
+		u16 len = (seg[0] << 8) | seg[1];
 
-	ret = copy_from_user(sof0, (void __user *)*cursor, sizeof(sof0));
-	if (ret) {
-		dev_err(ctx->smfc->dev, "Failed to read SOF0\n");
-		return ret;
+		ret = smfc_parse_table(ctx, ctx->tbl_cache[off], seg, len);
+		if (ret)
+			return ret;
+		off += 1 + len;
 	}
 
+	return 0;
+}
+
+#define SOF0_LENGTH 17 /* Lf+P+Y+X+Nf+Nf*Comp */
+static int smfc_parse_frameheader(struct smfc_ctx *ctx, const u8 *sof0)
+{
+	const u8 *pos = sof0;
+	int i;
+
 	if (__get_u16(pos) != SOF0_LENGTH) {
 		dev_err(ctx->smfc->dev, "Unsupported data in SOF0\n");
-		return ret;
+		return -EINVAL;
 	}
 
 	if (*pos != 8) { /* bits per sample */
@@ -275,32 +325,18 @@ static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
 		ctx->quantizer_tables->compsel[pos[0] - 1] = pos[2];
 	}
 
-	*cursor += SOF0_LENGTH;
-
 	return 0;
 }
 
 #define SOS_LENGTH 12 /* Ls+Ns+Ns*Comp+Ss+Se+AhAl */
-static int smfc_parse_scanheader(struct smfc_ctx *ctx,
-				 unsigned long streambase, unsigned long *cursor)
+static int smfc_parse_scanheader(struct smfc_ctx *ctx, const u8 *sos)
 {
-	u8 *pos;
-	int i, ret;
-	u8 sos[SOS_LENGTH];
-
-	pos = sos;
-
-	ctx->offset_of_sos = (unsigned int)(*cursor - streambase - SMFC_JPEG_MARKER_LEN);
-
-	ret = copy_from_user(sos, (void __user *)*cursor, sizeof(sos));
-	if (ret) {
-		dev_err(ctx->smfc->dev, "Failed to read SOS\n");
-		return ret;
-	}
+	const u8 *pos = sos;
+	int i;
 
 	if (__get_u16(pos) != SOS_LENGTH) {
 		dev_err(ctx->smfc->dev, "Unsupported length of SOS segment.\n");
-		return ret;
+		return -EINVAL;
 	}
 
 	if (*pos != 3 && *pos != 1) { /* Ns: number of components */
@@ -337,19 +373,22 @@ static int smfc_parse_scanheader(struct smfc_ctx *ctx,
 	 * during decompression.
 	 */
 
-	*cursor += SOS_LENGTH;
-
 	return 0;
 }
 
 int smfc_parse_jpeg_header(struct smfc_ctx *ctx, struct vb2_buffer *vb)
 {
+	struct smfc_stream stream = {
+		.size = vb2_get_plane_payload(vb, 0),
+	};
+	const u8 *p;
 	int ret;
-	union jpeg_hword_t marker;
 	u16 len;
-	unsigned long streambase = vb->planes[0].m.userptr;
-	unsigned long cursor = streambase;
-	unsigned long streamend = streambase + vb2_get_plane_payload(vb, 0);
+	size_t cursor = 0;
+	/* length of the table cache prefix matching this stream so far */
+	size_t cached = 0;
+	size_t cache_len;
+	bool cache_hit;
 
 	ctx->num_components = 0;
 
@@ -357,62 +396,145 @@ int smfc_parse_jpeg_header(struct smfc_ctx *ctx, struct vb2_buffer *vb)
 		return -ENOMEM;
 
 	/* the buffer in vb the entire JPEG stream from SOI */
+	if (vb->vb2_queue->memory == VB2_MEMORY_USERPTR) {
+		/* userptr: copy_from_user chunks of stream headers */
+		stream.uaddr = vb->planes[0].m.userptr;
+	} else {
+		/* mmap and dmabuf: map the buffer in the kernelspace once */
+		stream.kaddr = vb2_plane_vaddr(vb, 0);
+		if (!stream.kaddr) {
+			dev_err(ctx->smfc->dev, "Failed to map JPEG stream\n");
+			return -EFAULT;
+		}
+	}
 
-	/* userptr: get_user/copy_from_user to read stream headers */
-	/* dmabuf: map the buffer in the kernelspace to read stream headers */
+	/*
+	 * Tables are kept from the previous stream while its DHT and DQT
+	 * segments repeat byte by byte. The cache is valid again only after
+	 * this stream is parsed successfully.
+	 */
+	cache_len = ctx->tbl_cache_len;
+	cache_hit = cache_len != 0;
+	ctx->tbl_cache_len = 0;
+	if (!cache_hit)
+		smfc_reset_tables(ctx);
+	smfc_reset_compsel(ctx);
 
 	/* SOI */
-	ret = get_user(marker.byte[0], (u16 *)cursor++);
-	ret |= get_user(marker.byte[1], (u16 *)cursor++);
-	if (ret || marker.byte[0] != 0xFF || marker.byte[1] != 0xD8) {
+	p = smfc_stream_get(ctx, &stream, cursor, SMFC_JPEG_MARKER_LEN);
+	if (IS_ERR(p) || p[0] != 0xFF || p[1] != 0xD8) {
 		dev_err(ctx->smfc->dev, "SOS maker is not found\n");
 		return -EINVAL;
 	}
+	cursor += SMFC_JPEG_MARKER_LEN;
+
+	while (cursor + SMFC_JPEG_MARKER_LEN < stream.size) {
+		u8 marker;
 
-	while (cursor < streamend - SMFC_JPEG_MARKER_LEN) {
-		ret = get_user(marker.byte[0], (u16 *)cursor++);
-		ret |= get_user(marker.byte[1], (u16 *)cursor++);
-		if (ret) {
+		p = smfc_stream_get(ctx, &stream, cursor, SMFC_JPEG_MARKER_LEN);
+		if (IS_ERR(p)) {
 			dev_err(ctx->smfc->dev, "Failed to read JPEG maker\n");
 			return -EFAULT;
 		}
+		cursor += SMFC_JPEG_MARKER_LEN;
 
-		if (marker.byte[0] != 0xFF) {
+		if (p[0] != 0xFF) {
 			dev_err(ctx->smfc->dev, "Error found in JPEG stream\n");
 			return -EINVAL;
 		}
+		marker = p[1];
 
-		switch (marker.byte[1]) {
+		switch (marker) {
 		case 0xC4: /* DHT */
-			ret = smfc_parse_dht(ctx, &cursor);
+		case 0xDB: /* DQT */
+			ret = smfc_get_segment_length(ctx, &stream, cursor, marker, &len);
 			if (ret)
 				return ret;
-			break;
-		case 0xDB: /* DQT */
-			ret = smfc_parse_dqt(ctx, &cursor);
+
+			p = smfc_stream_get(ctx, &stream, cursor, len);
+			if (IS_ERR(p)) {
+				dev_err(ctx->smfc->dev,
+					"Failed to read segment 0xFF%02X\n", marker);
+				return PTR_ERR(p);
+			}
+			cursor += len;
+
+			if (cache_hit && cached + 1 + len <= cache_len &&
+			    ctx->tbl_cache[cached] == marker &&
+			    !memcmp(ctx->tbl_cache + cached + 1, p, len)) {
+				cached += 1 + len;
+				break;
+			}
+
+			if (cache_hit) {
+				cache_hit = false;
+				ret = smfc_replay_tbl_cache(ctx, cached);
+				if (ret)
+					return ret;
+			}
+
+			ret = smfc_parse_table(ctx, marker, p, len);
 			if (ret)
 				return ret;
+
+			if (cached + 1 + len <= SMFC_TBL_CACHE_SIZE) {
+				ctx->tbl_cache[cached] = marker;
+				memcpy(ctx->tbl_cache + cached + 1, p, len);
+				cached += 1 + len;
+			} else {
+				/* too many tables to remember, parse them always */
+				cached = SMFC_TBL_CACHE_SIZE + 1;
+			}
 			break;
 		case 0xC0: /* SOF0 */
-			ret = smfc_parse_frameheader(ctx, &cursor);
+			p = smfc_stream_get(ctx, &stream, cursor, SOF0_LENGTH);
+			if (IS_ERR(p)) {
+				dev_err(ctx->smfc->dev, "Failed to read SOF0\n");
+				return PTR_ERR(p);
+			}
+
+			ret = smfc_parse_frameheader(ctx, p);
 			if (ret)
 				return ret;
+			cursor += SOF0_LENGTH;
 			break;
 		case 0xDA: /**** SOS - THE END OF HEADER PARSING ****/
-			return smfc_parse_scanheader(ctx, streambase, &cursor);
+			ctx->offset_of_sos = (unsigned int)(cursor - SMFC_JPEG_MARKER_LEN);
+
+			p = smfc_stream_get(ctx, &stream, cursor, SOS_LENGTH);
+			if (IS_ERR(p)) {
+				dev_err(ctx->smfc->dev, "Failed to read SOS\n");
+				return PTR_ERR(p);
+			}
+
+			/* the previous stream had more tables than this one */
+			if (cache_hit && cached != cache_len) {
+				ret = smfc_replay_tbl_cache(ctx, cached);
+				if (ret)
+					return ret;
+			}
+
+			ret = smfc_parse_scanheader(ctx, p);
+			if (ret)
+				return ret;
+
+			if (cached <= SMFC_TBL_CACHE_SIZE)
+				ctx->tbl_cache_len = cached;
+
+			return 0;
 		case 0xD9: /* EOI */
 			dev_err(ctx->smfc->dev,
 				"EOI found during header parsing\n");
 			return -EINVAL;
 		default: /* error checking */
-			if ((marker.byte[1] & 0xF0) == 0xC0) {
+			if ((marker & 0xF0) == 0xC0) {
 				dev_err(ctx->smfc->dev, "Unsupported marker 0xFF%02X found\n",
-					marker.byte[1]);
+					marker);
 				return -EINVAL;
 			}
 
 			/* Ignores all other markers */
-			ret = smfc_get_segment_length(ctx, cursor, marker.byte[1], &len);
+			ret = smfc_get_segment_length(ctx, &stream, cursor, marker, &len);
 			if (ret)
 				return ret;
 
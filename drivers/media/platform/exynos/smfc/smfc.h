@@ -233,6 +233,12 @@ struct smfc_ctx {
 	unsigned int offset_of_sos;
 	__u16 stream_width;
 	__u16 stream_height;
+	/* header bytes copied from userptr streams */
+	u8 *parse_buf;
+	size_t parse_buf_size;
+	/* DHT and DQT segments the current tables were parsed from */
+	u8 *tbl_cache;
+	size_t tbl_cache_len;
 };
 
 extern const struct v4l2_ioctl_ops smfc_v4l2_ioctl_ops;
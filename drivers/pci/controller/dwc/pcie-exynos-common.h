@@ -228,6 +228,8 @@ scnprintf((buf) + (ret), PAGE_SIZE - (ret), \
 )
 
 struct exynos_pcie;
+struct exynos_pcie_rx_pool;
+struct phys_mem;
 
 struct pcie_phyops {
 	void (*phy_check_rx_elecidle)(void *phy_pcs_base_regs, int val, int ch_num);
@@ -254,6 +256,8 @@ struct exynos_pcie {
 	struct dw_pcie		*pci;
 #if IS_ENABLED(CONFIG_GS_S2MPU)
 	struct list_head	phys_mem_list;
+	struct phys_mem		*phys_mem_tbl;	/* sorted by start address */
+	int			nr_phys_mem;
 #endif
 	struct s2mpu_info	*s2mpu;
 	struct pci_dev		*ep_pci_dev;
@@ -307,6 +311,8 @@ struct exynos_pcie {
 	spinlock_t		power_stats_lock;	/* pcie config - power state change */
 	spinlock_t		link_duration_lock; /* pcie link speed duration 		*/
 	spinlock_t		s2mpu_refcnt_lock;
+	struct exynos_pcie_rx_pool __rcu *rx_pool;	/* pre-mapped RX buffers */
+	atomic_t		page_map_cnt;	/* unpooled map_page in flight */
 	struct workqueue_struct	*pcie_wq;
 	struct exynos_pcie_clks	clks;
 	struct pci_dev		*pci_dev;
@@ -8,9 +8,11 @@
  * Author: Hongseock Kim <hongpooh.kim@samsung.com>
  */
 
+#include <linux/bsearch.h>
 #include <linux/clk.h>
 #include <linux/delay.h>
 #include <linux/gpio.h>
+#include <linux/hashtable.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
 #include <linux/mfd/syscon.h>
@@ -24,6 +26,7 @@
 #include <linux/signal.h>
 #include <linux/types.h>
 #include <linux/pm_qos.h>
+#include <linux/rculist.h>
 #include <dt-bindings/pci/pci.h>
 #include <linux/exynos-pci-noti.h>
 #include <linux/exynos-pci-ctrl.h>
@@ -89,6 +92,29 @@ struct exynos_pm_qos_request exynos_pcie_int_qos[MAX_RC_NUM];
  */
 #define pcie_ch_to_hsi(ch_num)	((ch_num) + 1)
 #define to_pci_dev_from_dev(dev) container_of((dev), struct pci_dev, dev)
+
+/*
+ * RX buffer pool. Pages registered by the EP driver stay mapped in the
+ * S2MPU/SysMMU for the lifetime of the pool, so map_page/unmap_page on them
+ * only do cache maintenance. Pool pages are naturally aligned blocks of
+ * (1 << shift) bytes and are hashed by block number.
+ */
+#define PCIE_RX_POOL_HASH_BITS	8
+
+struct exynos_pcie_rx_pool_entry {
+	struct hlist_node	node;
+	dma_addr_t		dma_addr;
+};
+
+struct exynos_pcie_rx_pool {
+	DECLARE_HASHTABLE(hash, PCIE_RX_POOL_HASH_BITS);
+	struct exynos_pcie_rx_pool_entry *entries;
+	int			nr_pages;
+	unsigned int		shift;
+	atomic64_t		hit;
+	atomic64_t		miss;
+};
+
 #if IS_ENABLED(CONFIG_GS_S2MPU) || IS_ENABLED(CONFIG_EXYNOS_PCIE_IOMMU)
 static const struct dma_map_ops pcie_dma_ops;
 static struct device fake_dma_dev;
@@ -107,20 +133,33 @@ struct phys_mem {
 #define ALIGN_SIZE	0x1000UL
 #define REF_COUNT_UNDERFLOW 255
 
+static int s2mpu_phys_mem_cmp(const void *key, const void *elt)
+{
+	phys_addr_t addr = *(const phys_addr_t *)key;
+	const struct phys_mem *pm = elt;
+
+	if (addr < pm->start)
+		return -1;
+	if (addr >= pm->start + pm->size)
+		return 1;
+	return 0;
+}
+
 unsigned char *s2mpu_get_refcnt_ptr(struct exynos_pcie *exynos_pcie,
 				    phys_addr_t addr)
 {
 	struct phys_mem *pm;
 
 	/* Find the memory region the address falls into, then determine the
-	 * offset into the corresponding refcnt_array.
+	 * offset into the corresponding refcnt_array. The table is sorted by
+	 * start address at probe time.
 	 */
-	list_for_each_entry(pm, &exynos_pcie->phys_mem_list, list) {
-		if (addr >= pm->start && addr < (pm->start + pm->size))
-			return pm->refcnt_array
-			       + (addr - pm->start) / ALIGN_SIZE;
-	}
-	return NULL;
+	pm = bsearch(&addr, exynos_pcie->phys_mem_tbl, exynos_pcie->nr_phys_mem,
+		     sizeof(*pm), s2mpu_phys_mem_cmp);
+	if (!pm)
+		return NULL;
+
+	return pm->refcnt_array + (addr - pm->start) / ALIGN_SIZE;
 }
 
 void s2mpu_get_alignment(dma_addr_t addr, size_t size,
@@ -153,6 +192,22 @@ unsigned char s2mpu_get_and_modify(struct exynos_pcie *exynos_pcie,
 	return val;
 }
 
+static void s2mpu_open_close_run(struct device *dev,
+				 struct exynos_pcie *exynos_pcie,
+				 phys_addr_t addr, size_t size, bool open,
+				 enum dma_data_direction dir)
+{
+	int ret;
+
+	if (open)
+		ret = s2mpu_open(exynos_pcie->s2mpu, addr, size, dir);
+	else
+		ret = s2mpu_close(exynos_pcie->s2mpu, addr, size, dir);
+	if (ret)
+		dev_err(dev, "s2mpu_%s failed addr=%pa, size=%zx\n",
+			open ? "open" : "close", &addr, size);
+}
+
 void s2mpu_update_refcnt(struct device *dev,
 			 dma_addr_t dma_addr, size_t size, bool incr,
 			 enum dma_data_direction dir)
@@ -161,7 +216,8 @@ void s2mpu_update_refcnt(struct device *dev,
 	phys_addr_t align_addr;
 	size_t align_size;
 	unsigned char *refcnt_ptr;
-	int ret;
+	phys_addr_t run_addr;
+	size_t run_size;
 	unsigned char refcnt;
 	unsigned long flags;
 
@@ -184,51 +240,296 @@ void s2mpu_update_refcnt(struct device *dev,
 	}
 
 	/* Put lock on while-loop to protect race condition on
-	 * s2mpu_open/s2mpu_close and the case of align_size over 4K */
+	 * s2mpu_open/s2mpu_close and the case of align_size over 4K.
+	 * Blocks whose count goes 0->1 (or 1->0) are collected into runs so
+	 * that each contiguous run costs a single s2mpu_open/s2mpu_close.
+	 */
 	spin_lock_irqsave(&exynos_pcie->s2mpu_refcnt_lock, flags);
+	run_addr = align_addr;
+	run_size = 0;
 	while (align_size != 0) {
-		if (incr) {
-			refcnt = s2mpu_get_and_modify(exynos_pcie, refcnt_ptr,
-						      true);
-			/* Note that this will open the memory with read/write
-			 * permissions based on the first invocation. Subsequent
-			 * read/write permissions will be ignored.
-			 */
-			if (refcnt == 1) {
-				ret = s2mpu_open(exynos_pcie->s2mpu,
-						 align_addr, ALIGN_SIZE, dir);
-				if (ret) {
-					dev_err(dev,
-						"s2mpu_open failed addr=%pad, size=%zx\n",
-						&dma_addr, size);
-				}
-			}
-		} else {
-			refcnt = s2mpu_get_and_modify(exynos_pcie, refcnt_ptr,
-						      false);
-			if (refcnt == REF_COUNT_UNDERFLOW) {
-				dev_err(dev, "s2mpu error underflow in refcount\n");
-				spin_unlock_irqrestore(&exynos_pcie->s2mpu_refcnt_lock, flags);
-				return;
-			}
-			if (refcnt == 0) {
-				ret = s2mpu_close(exynos_pcie->s2mpu,
-						  align_addr, ALIGN_SIZE, dir);
-				if (ret) {
-					dev_err(dev,
-						"s2mpu_close failed addr=%pad, size=%zx\n",
-						&dma_addr, size);
-				}
-			}
+		refcnt = s2mpu_get_and_modify(exynos_pcie, refcnt_ptr, incr);
+		if (!incr && refcnt == REF_COUNT_UNDERFLOW) {
+			dev_err(dev, "s2mpu error underflow in refcount\n");
+			break;
 		}
+
+		/* Note that this will open the memory with read/write
+		 * permissions based on the first invocation. Subsequent
+		 * read/write permissions will be ignored.
+		 */
+		if (refcnt == (incr ? 1 : 0)) {
+			if (!run_size)
+				run_addr = align_addr;
+			run_size += ALIGN_SIZE;
+		} else if (run_size) {
+			s2mpu_open_close_run(dev, exynos_pcie, run_addr,
+					     run_size, incr, dir);
+			run_size = 0;
+		}
+
 		align_addr += ALIGN_SIZE;
 		align_size -= ALIGN_SIZE;
 		refcnt_ptr++;
 	}
+	if (run_size)
+		s2mpu_open_close_run(dev, exynos_pcie, run_addr, run_size,
+				     incr, dir);
 	spin_unlock_irqrestore(&exynos_pcie->s2mpu_refcnt_lock, flags);
 }
 #endif
 
+static DEFINE_MUTEX(rx_pool_lock);
+
+static struct exynos_pcie_rx_pool_entry *
+exynos_pcie_rx_pool_find(struct exynos_pcie_rx_pool *pool, dma_addr_t addr,
+			 size_t size)
+{
+	struct exynos_pcie_rx_pool_entry *entry;
+	dma_addr_t key = addr >> pool->shift;
+
+	hash_for_each_possible_rcu(pool->hash, entry, node, key) {
+		if ((entry->dma_addr >> pool->shift) != key)
+			continue;
+		/* a buffer crossing the end of a pool page is not pooled */
+		if (addr + size > entry->dma_addr + (1UL << pool->shift))
+			return NULL;
+		return entry;
+	}
+
+	return NULL;
+}
+
+static int exynos_pcie_rx_pool_map(struct exynos_pcie *exynos_pcie,
+				   dma_addr_t dma_addr, size_t size)
+{
+	if (exynos_pcie->s2mpu) {
+		s2mpu_update_refcnt(exynos_pcie->pci->dev, dma_addr, size, true,
+				    DMA_BIDIRECTIONAL);
+		return 0;
+	}
+
+	return pcie_iommu_map(dma_addr, dma_addr, size, DMA_BIDIRECTIONAL,
+			      pcie_ch_to_hsi(exynos_pcie->ch_num));
+}
+
+static void exynos_pcie_rx_pool_unmap(struct exynos_pcie *exynos_pcie,
+				      dma_addr_t dma_addr, size_t size)
+{
+	if (exynos_pcie->s2mpu)
+		s2mpu_update_refcnt(exynos_pcie->pci->dev, dma_addr, size, false,
+				    DMA_BIDIRECTIONAL);
+	else
+		pcie_iommu_unmap(dma_addr, size,
+				 pcie_ch_to_hsi(exynos_pcie->ch_num));
+}
+
+static void exynos_pcie_rx_pool_release(struct exynos_pcie *exynos_pcie,
+					struct exynos_pcie_rx_pool *pool)
+{
+	size_t size = 1UL << pool->shift;
+	int i;
+
+	for (i = 0; i < pool->nr_pages; i++) {
+		dma_addr_t dma_addr = pool->entries[i].dma_addr;
+
+		exynos_pcie_rx_pool_unmap(exynos_pcie, dma_addr, size);
+		dma_unmap_page_attrs(&exynos_pcie->dup_ep_dev, dma_addr, size,
+				     DMA_BIDIRECTIONAL, DMA_ATTR_SKIP_CPU_SYNC);
+	}
+
+	kfree(pool->entries);
+	kfree(pool);
+}
+
+int exynos_pcie_rc_rx_pool_register(int ch_num, struct page **pages,
+				    int nr_pages, unsigned int order)
+{
+	struct exynos_pcie *exynos_pcie;
+	struct device *dev;
+	struct exynos_pcie_rx_pool *pool;
+	size_t size = PAGE_SIZE << order;
+	int i, ret = 0;
+
+	if (ch_num < 0 || ch_num >= MAX_RC_NUM)
+		return -EINVAL;
+
+	exynos_pcie = &g_pcie_rc[ch_num];
+	if (!exynos_pcie->pci)
+		return -ENODEV;
+	dev = exynos_pcie->pci->dev;
+
+	if (!exynos_pcie->s2mpu && !exynos_pcie->use_sysmmu)
+		return -ENODEV;
+
+	/* dup_ep_dev is only valid once the EP has been enumerated */
+	if (!exynos_pcie->ep_pci_dev)
+		return -ENODEV;
+
+	if (!pages || nr_pages <= 0)
+		return -EINVAL;
+
+	mutex_lock(&rx_pool_lock);
+
+	if (rcu_access_pointer(exynos_pcie->rx_pool)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/*
+	 * Pooled unmaps are told apart by address only, a buffer mapped the
+	 * normal way before the pool existed would be unmapped as pooled and
+	 * leak its mapping. Register before the EP starts mapping buffers.
+	 */
+	if (atomic_read(&exynos_pcie->page_map_cnt)) {
+		dev_err(dev, "RX pool: %d buffers still mapped\n",
+			atomic_read(&exynos_pcie->page_map_cnt));
+		ret = -EBUSY;
+		goto out;
+	}
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	pool->entries = kcalloc(nr_pages, sizeof(*pool->entries), GFP_KERNEL);
+	if (!pool->entries) {
+		kfree(pool);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	hash_init(pool->hash);
+	pool->shift = PAGE_SHIFT + order;
+
+	for (i = 0; i < nr_pages; i++) {
+		struct exynos_pcie_rx_pool_entry *entry = &pool->entries[i];
+		dma_addr_t dma_addr;
+
+		dma_addr = dma_map_page_attrs(&exynos_pcie->dup_ep_dev, pages[i],
+					      0, size, DMA_BIDIRECTIONAL,
+					      DMA_ATTR_SKIP_CPU_SYNC);
+		if (dma_mapping_error(&exynos_pcie->dup_ep_dev, dma_addr)) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		/* S2MPU/SysMMU windows are 1:1, bounced pages can't be pooled */
+		if (dma_addr != page_to_phys(pages[i]) ||
+		    !IS_ALIGNED(dma_addr, size)) {
+			ret = -EINVAL;
+		} else {
+			ret = exynos_pcie_rx_pool_map(exynos_pcie, dma_addr,
+						      size);
+		}
+		if (ret) {
+			dma_unmap_page_attrs(&exynos_pcie->dup_ep_dev, dma_addr,
+					     size, DMA_BIDIRECTIONAL,
+					     DMA_ATTR_SKIP_CPU_SYNC);
+			break;
+		}
+
+		entry->dma_addr = dma_addr;
+		hash_add(pool->hash, &entry->node, dma_addr >> pool->shift);
+		pool->nr_pages++;
+	}
+
+	if (ret) {
+		dev_err(dev, "RX pool: can't map page %d (%d)\n", i, ret);
+		exynos_pcie_rx_pool_release(exynos_pcie, pool);
+		goto out;
+	}
+
+	rcu_assign_pointer(exynos_pcie->rx_pool, pool);
+	dev_info(dev, "RX pool: %d pages of %zu bytes mapped\n", nr_pages, size);
+out:
+	mutex_unlock(&rx_pool_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(exynos_pcie_rc_rx_pool_register);
+
+void exynos_pcie_rc_rx_pool_unregister(int ch_num)
+{
+	struct exynos_pcie *exynos_pcie;
+	struct exynos_pcie_rx_pool *pool;
+
+	if (ch_num < 0 || ch_num >= MAX_RC_NUM)
+		return;
+
+	exynos_pcie = &g_pcie_rc[ch_num];
+
+	mutex_lock(&rx_pool_lock);
+
+	pool = rcu_dereference_protected(exynos_pcie->rx_pool,
+					 lockdep_is_held(&rx_pool_lock));
+	if (pool) {
+		RCU_INIT_POINTER(exynos_pcie->rx_pool, NULL);
+		synchronize_rcu();
+
+		dev_info(exynos_pcie->pci->dev, "RX pool: hit %lld miss %lld\n",
+			 atomic64_read(&pool->hit), atomic64_read(&pool->miss));
+		exynos_pcie_rx_pool_release(exynos_pcie, pool);
+	}
+
+	mutex_unlock(&rx_pool_lock);
+}
+EXPORT_SYMBOL_GPL(exynos_pcie_rc_rx_pool_unregister);
+
+static bool exynos_pcie_rx_pool_map_page(struct exynos_pcie *exynos_pcie,
+					 struct page *page, size_t offset,
+					 size_t size, enum dma_data_direction dir,
+					 unsigned long attrs, dma_addr_t *dma_addr)
+{
+	struct exynos_pcie_rx_pool *pool;
+	dma_addr_t addr = page_to_phys(page) + offset;
+	bool pooled = false;
+
+	rcu_read_lock();
+	pool = rcu_dereference(exynos_pcie->rx_pool);
+	if (!pool)
+		goto out;
+
+	if (!exynos_pcie_rx_pool_find(pool, addr, size)) {
+		atomic64_inc(&pool->miss);
+		goto out;
+	}
+
+	if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+		dma_sync_single_for_device(&exynos_pcie->dup_ep_dev, addr,
+					   size, dir);
+	atomic64_inc(&pool->hit);
+	*dma_addr = addr;
+	pooled = true;
+out:
+	rcu_read_unlock();
+
+	return pooled;
+}
+
+static bool exynos_pcie_rx_pool_unmap_page(struct exynos_pcie *exynos_pcie,
+					   dma_addr_t dma_addr, size_t size,
+					   enum dma_data_direction dir,
+					   unsigned long attrs)
+{
+	struct exynos_pcie_rx_pool *pool;
+	bool pooled = false;
+
+	rcu_read_lock();
+	pool = rcu_dereference(exynos_pcie->rx_pool);
+	if (pool && exynos_pcie_rx_pool_find(pool, dma_addr, size)) {
+		if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+			dma_sync_single_for_cpu(&exynos_pcie->dup_ep_dev,
+						dma_addr, size, dir);
+		pooled = true;
+	}
+	rcu_read_unlock();
+
+	return pooled;
+}
+
 static void exynos_pcie_mem_copy_epdev(struct exynos_pcie *exynos_pcie)
 {
 	struct device *epdev = &exynos_pcie->ep_pci_dev->dev;
@@ -328,6 +629,10 @@ static dma_addr_t pcie_dma_map_page(struct device *dev, struct page *page,
 
 	exynos_pcie = &g_pcie_rc[ch_num];
 
+	if (exynos_pcie_rx_pool_map_page(exynos_pcie, page, offset, size, dir,
+					 attrs, &dma_addr))
+		return dma_addr;
+
 	dma_addr = dma_map_page_attrs(&exynos_pcie->dup_ep_dev, page, offset,
 				      size, dir, attrs);
 	if (exynos_pcie->s2mpu) {
@@ -340,6 +645,8 @@ static dma_addr_t pcie_dma_map_page(struct device *dev, struct page *page,
 			return 0;
 		}
 	}
+	if (dma_addr != DMA_MAPPING_ERROR)
+		atomic_inc(&exynos_pcie->page_map_cnt);
 	return dma_addr;
 }
 
@@ -359,7 +666,12 @@ static void pcie_dma_unmap_page(struct device *dev, dma_addr_t dma_addr,
 
 	exynos_pcie = &g_pcie_rc[ch_num];
 
+	if (exynos_pcie_rx_pool_unmap_page(exynos_pcie, dma_addr, size, dir,
+					   attrs))
+		return;
+
 	dma_unmap_page_attrs(&exynos_pcie->dup_ep_dev, dma_addr, size, dir, attrs);
+	atomic_dec(&exynos_pcie->page_map_cnt);
 
 	if (exynos_pcie->s2mpu)
 		s2mpu_update_refcnt(dev, dma_addr, size, false, dir);
@@ -367,6 +679,87 @@ static void pcie_dma_unmap_page(struct device *dev, dma_addr_t dma_addr,
 		pcie_iommu_unmap(dma_addr, size, pcie_ch_to_hsi(ch_num));
 }
 
+static int pcie_dma_map_sg(struct device *dev, struct scatterlist *sgl,
+			   int nents, enum dma_data_direction dir,
+			   unsigned long attrs)
+{
+	struct pci_dev *epdev = to_pci_dev_from_dev(dev);
+	int ch_num = 0;
+	struct exynos_pcie *exynos_pcie;
+	struct scatterlist *sg;
+	int i, mapped, ret = 0;
+
+	if (unlikely(dev == NULL)) {
+		pr_err("EP device is NULL!!!\n");
+		return -EINVAL;
+	}
+	ch_num = pci_domain_nr(epdev->bus);
+
+	exynos_pcie = &g_pcie_rc[ch_num];
+
+	/*
+	 * dup_ep_dev has no dma_ops, so this is dma-direct, which never merges
+	 * entries: on success every one of the nents entries is mapped.
+	 */
+	mapped = dma_map_sg_attrs(&exynos_pcie->dup_ep_dev, sgl, nents,
+				  dir, attrs);
+	if (!mapped)
+		return -EIO;
+	if (WARN_ON(mapped != nents)) {
+		dma_unmap_sg_attrs(&exynos_pcie->dup_ep_dev, sgl, nents,
+				   dir, attrs);
+		return -EIO;
+	}
+
+	if (exynos_pcie->s2mpu) {
+		for_each_sg(sgl, sg, mapped, i)
+			s2mpu_update_refcnt(dev, sg_dma_address(sg),
+					    sg_dma_len(sg), true, dir);
+	} else if (exynos_pcie->use_sysmmu) {
+		/* One page table walk and TLB invalidation for the whole list */
+		ret = pcie_iommu_map_sg(sgl, mapped, dir,
+					pcie_ch_to_hsi(ch_num));
+		if (ret != 0) {
+			pr_err("DMA map - Can't map PCIe SysMMU table!!!\n");
+			dma_unmap_sg_attrs(&exynos_pcie->dup_ep_dev, sgl, nents,
+					   dir, attrs);
+			/* map_sg may only fail with -EINVAL, -ENOMEM or -EIO */
+			return ret == -ENOMEM ? -ENOMEM : -EIO;
+		}
+	}
+	return mapped;
+}
+
+static void pcie_dma_unmap_sg(struct device *dev, struct scatterlist *sgl,
+			      int nents, enum dma_data_direction dir,
+			      unsigned long attrs)
+{
+	struct pci_dev *epdev = to_pci_dev_from_dev(dev);
+	int ch_num = 0;
+	struct exynos_pcie *exynos_pcie;
+	struct scatterlist *sg;
+	int i;
+
+	if (unlikely(dev == NULL)) {
+		pr_err("EP device is NULL!!!\n");
+		return;
+	}
+	ch_num = pci_domain_nr(epdev->bus);
+
+	exynos_pcie = &g_pcie_rc[ch_num];
+
+	/* pcie_dma_map_sg() only succeeds with all nents entries mapped */
+	if (exynos_pcie->s2mpu) {
+		for_each_sg(sgl, sg, nents, i)
+			s2mpu_update_refcnt(dev, sg_dma_address(sg),
+					    sg_dma_len(sg), false, dir);
+	} else if (exynos_pcie->use_sysmmu) {
+		pcie_iommu_unmap_sg(sgl, nents, pcie_ch_to_hsi(ch_num));
+	}
+
+	dma_unmap_sg_attrs(&exynos_pcie->dup_ep_dev, sgl, nents, dir, attrs);
+}
+
 static const struct dma_map_ops pcie_dma_ops = {
 	.alloc = pcie_dma_alloc_attrs,
 	.free = pcie_dma_free_attrs,
@@ -374,8 +767,8 @@ static const struct dma_map_ops pcie_dma_ops = {
 	.get_sgtable = NULL,
 	.map_page = pcie_dma_map_page,
 	.unmap_page = pcie_dma_unmap_page,
-	.map_sg = NULL,
-	.unmap_sg = NULL,
+	.map_sg = pcie_dma_map_sg,
+	.unmap_sg = pcie_dma_unmap_sg,
 	.map_resource = NULL,
 	.unmap_resource = NULL,
 	.sync_single_for_cpu = NULL,
@@ -388,6 +781,18 @@ static const struct dma_map_ops pcie_dma_ops = {
 	.max_mapping_size = NULL,
 	.get_merge_boundary = NULL,
 };
+#else
+int exynos_pcie_rc_rx_pool_register(int ch_num, struct page **pages,
+				    int nr_pages, unsigned int order)
+{
+	return -ENODEV;
+}
+EXPORT_SYMBOL_GPL(exynos_pcie_rc_rx_pool_register);
+
+void exynos_pcie_rc_rx_pool_unregister(int ch_num)
+{
+}
+EXPORT_SYMBOL_GPL(exynos_pcie_rc_rx_pool_unregister);
 #endif
 
 static void exynos_pcie_phy_isolation(struct exynos_pcie *exynos_pcie, int val)
@@ -1013,12 +1418,33 @@ static ssize_t link_duration_show(struct device *dev,
 	return ret;
 }
 
+static ssize_t rx_pool_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct exynos_pcie *exynos_pcie = dev_get_drvdata(dev);
+	struct exynos_pcie_rx_pool *pool;
+	int ret;
+
+	rcu_read_lock();
+	pool = rcu_dereference(exynos_pcie->rx_pool);
+	if (pool)
+		ret = sysfs_emit(buf, "pages: %d\nhit: %lld\nmiss: %lld\n",
+				 pool->nr_pages, atomic64_read(&pool->hit),
+				 atomic64_read(&pool->miss));
+	else
+		ret = sysfs_emit(buf, "pages: 0\n");
+	rcu_read_unlock();
+
+	return ret;
+}
+
 static DEVICE_ATTR_RW(link_speed);
 static DEVICE_ATTR_RW(link_width);
 static DEVICE_ATTR_RO(link_state);
 static DEVICE_ATTR_RO(power_stats);
 static DEVICE_ATTR_RW(sbb_debug);
 static DEVICE_ATTR_RO(link_duration);
+static DEVICE_ATTR_RO(rx_pool);
 
 /* percentage (0-100) to weight new datapoints in moving average */
 #define NEW_DATA_AVERAGE_WEIGHT  10
@@ -1407,6 +1833,12 @@ static inline int create_pcie_sys_file(struct device *dev)
 		return ret;
 	}
 
+	ret = device_create_file(dev, &dev_attr_rx_pool);
+	if (ret) {
+		dev_err(dev, "couldn't create device file for rx_pool(%d)\n", ret);
+		return ret;
+	}
+
 	ret = sysfs_create_group(&pdev->dev.kobj, &link_stats_group);
 	if (ret) {
 		dev_err(dev, "couldn't create sysfs group for link_stats(%d)\n", ret);
@@ -1433,6 +1865,7 @@ static inline void remove_pcie_sys_file(struct device *dev)
 	device_remove_file(dev, &dev_attr_link_state);
 	device_remove_file(dev, &dev_attr_power_stats);
 	device_remove_file(dev, &dev_attr_link_duration);
+	device_remove_file(dev, &dev_attr_rx_pool);
 	sysfs_remove_group(&pdev->dev.kobj, &link_stats_group);
 	sysfs_remove_group(&pdev->dev.kobj, &l1ss_group);
 }
@@ -5408,6 +5841,7 @@ static int setup_s2mpu_mem(struct device *dev, struct exynos_pcie *exynos_pcie)
 	struct resource res;
 	struct phys_mem *pm;
 	phys_addr_t addr;
+	int nr_phys_mem = 0;
 	int ret;
 
 	/* Parse the memory nodes in the device tree to determine which areas
@@ -5460,12 +5894,24 @@ static int setup_s2mpu_mem(struct device *dev, struct exynos_pcie *exynos_pcie)
 		}
 	}
 
+	list_for_each_entry(pm, &exynos_pcie->phys_mem_list, list)
+		nr_phys_mem++;
+
+	exynos_pcie->phys_mem_tbl = devm_kcalloc(dev, nr_phys_mem,
+						 sizeof(*pm), GFP_KERNEL);
+	if (!exynos_pcie->phys_mem_tbl)
+		return -ENOMEM;
+
+	/* The list is in descending order, the lookup table ascending. */
 	list_for_each_entry(pm, &exynos_pcie->phys_mem_list, list) {
 		pm->refcnt_array = devm_kzalloc(dev, pm->size / SZ_4K,
 						GFP_KERNEL);
 		if (!pm->refcnt_array)
 			return -ENOMEM;
 
+		exynos_pcie->phys_mem_tbl[--nr_phys_mem] = *pm;
+		exynos_pcie->nr_phys_mem++;
+
 		/* Optimize s2mpu operation by setting up 1G page tables */
 		addr = pm->start;
 		while (addr <  pm->start + pm->size) {
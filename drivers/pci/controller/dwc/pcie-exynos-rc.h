@@ -383,6 +383,20 @@ static size_t __maybe_unused pcie_iommu_unmap(unsigned long iova, size_t size,
 	pr_err("PCIe SysMMU is Unmapped!!!\n");
 	return 0;
 }
+
+static int __maybe_unused pcie_iommu_map_sg(struct scatterlist *sgl, int nents,
+					    int prot, int hsi_block_num)
+{
+	pr_err("PCIe SysMMU is Mapped!!!\n");
+	return -ENODEV;
+}
+
+static size_t __maybe_unused pcie_iommu_unmap_sg(struct scatterlist *sgl,
+					       int nents, int hsi_block_num)
+{
+	pr_err("PCIe SysMMU is Unmapped!!!\n");
+	return 0;
+}
 #endif
 
 #if !IS_ENABLED(CONFIG_GS_S2MPU)
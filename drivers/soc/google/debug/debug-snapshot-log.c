@@ -40,6 +40,7 @@ struct dbg_snapshot_log_item dss_log_items[] = {
 	[DSS_LOG_THERMAL_ID]	= {DSS_LOG_THERMAL,	{0, 0, 0, true}, },
 	[DSS_LOG_ACPM_ID]	= {DSS_LOG_ACPM,	{0, 0, 0, true}, },
 	[DSS_LOG_PRINTK_ID]	= {DSS_LOG_PRINTK,	{0, 0, 0, true}, },
+	[DSS_LOG_PRINTK_BIN_ID]	= {DSS_LOG_PRINTK_BIN,	{0, 0, 0, true}, },
 };
 
 /*  Internal interface variable */
@@ -147,7 +148,8 @@ dss_get_log(dm);
 dss_get_log(regulator);
 dss_get_log(thermal);
 dss_get_log(acpm);
-dss_get_log(print);
+dss_get_log_by_cpu(print);
+dss_get_log_by_cpu(print_bin);
 
 #define log_item_set_filed(id, log_name)				\
 		log_item = &dss_log_items[DSS_LOG_##id##_ID];		\
@@ -532,6 +534,8 @@ EXPORT_SYMBOL_GPL(dbg_snapshot_acpm);
 
 void dbg_snapshot_printk(const char *fmt, ...)
 {
+	int cpu = raw_smp_processor_id();
+	struct print_log *log;
 	unsigned long i;
 	va_list args;
 
@@ -540,19 +544,41 @@ void dbg_snapshot_printk(const char *fmt, ...)
 	if (!dbg_snapshot_is_log_item_enabled(DSS_LOG_PRINTK_ID))
 		return;
 
-	i = atomic_fetch_inc(&dss_log_misc.print_log_idx) %
-		ARRAY_SIZE(dss_log->print);
+	i = atomic_fetch_inc(&dss_log_misc.print_log_idx[cpu]) %
+		ARRAY_SIZE(dss_log->print[0]);
+	log = &dss_log->print[cpu][i];
 
 	va_start(args, fmt);
-	vsnprintf(dss_log->print[i].log, sizeof(dss_log->print[i].log),
-			fmt, args);
+	vsnprintf(log->log, sizeof(log->log), fmt, args);
 	va_end(args);
 
-	dss_log->print[i].time = local_clock();
-	dss_log->print[i].cpu = raw_smp_processor_id();
+	log->time = local_clock();
+	log->cpu = cpu;
 }
 EXPORT_SYMBOL_GPL(dbg_snapshot_printk);
 
+void __dbg_snapshot_printk_bin(const char *fmt, int nr_args, const u64 *args)
+{
+	int cpu = raw_smp_processor_id();
+	struct print_bin_log *log;
+	unsigned long i;
+
+	if (!dss_log)
+		return;
+	if (!dbg_snapshot_is_log_item_enabled(DSS_LOG_PRINTK_BIN_ID))
+		return;
+
+	i = atomic_fetch_inc(&dss_log_misc.print_bin_log_idx[cpu]) %
+		ARRAY_SIZE(dss_log->print_bin[0]);
+	log = &dss_log->print_bin[cpu][i];
+
+	log->time = local_clock();
+	log->fmt = fmt;
+	log->nr_args = nr_args;
+	memcpy(log->args, args, sizeof(log->args));
+}
+EXPORT_SYMBOL_GPL(__dbg_snapshot_printk_bin);
+
 void dbg_snapshot_itmon_irq_received(void)
 {
 	if (!dss_itmon)
@@ -745,6 +771,75 @@ static void dbg_snapshot_print_freqinfo(void)
 	}
 }
 
+#define DSS_PRINT_BIN_REPORT_NUM	4
+
+/*
+ * The binary log keeps format strings by pointer, forget the ones of a module
+ * going away so the panic report never formats through unmapped memory.
+ */
+static int dbg_snapshot_print_bin_module_notify(struct notifier_block *nb,
+						unsigned long action, void *data)
+{
+	struct module *mod = data;
+	struct print_bin_log *log;
+	int cpu, i;
+
+	if (action != MODULE_STATE_GOING || !dss_log)
+		return NOTIFY_DONE;
+
+	for (cpu = 0; cpu < ARRAY_SIZE(dss_log->print_bin); cpu++) {
+		for (i = 0; i < ARRAY_SIZE(dss_log->print_bin[cpu]); i++) {
+			log = &dss_log->print_bin[cpu][i];
+			if (within_module((unsigned long)READ_ONCE(log->fmt), mod))
+				WRITE_ONCE(log->fmt, NULL);
+		}
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block dss_print_bin_module_nb = {
+	.notifier_call = dbg_snapshot_print_bin_module_notify,
+};
+
+static void dbg_snapshot_print_printk_bin(void)
+{
+	struct dbg_snapshot_log_item *log_item = &dss_log_items[DSS_LOG_PRINTK_BIN_ID];
+	unsigned int nr_cpu = dbg_snapshot_get_max_core_num();
+	unsigned long sec, msec;
+	char buf[DSS_LOG_STRING_LEN];
+	struct print_bin_log *log;
+	const char *fmt;
+	int cpu, i;
+	long idx;
+
+	if (!dss_log)
+		return;
+	if (!log_item->entry.enabled)
+		return;
+
+	pr_info("\n<last printk info>\n");
+	for (cpu = 0; cpu < nr_cpu; cpu++) {
+		idx = dss_get_last_print_bin_log_idx(cpu);
+		for (i = DSS_PRINT_BIN_REPORT_NUM - 1; i >= 0; i--) {
+			log = dss_get_print_bin_log_by_cpu_iter(cpu, idx - i);
+			fmt = READ_ONCE(log->fmt);
+			if (!fmt)
+				continue;
+
+			/*
+			 * Each argument takes a full 64-bit slot of the va_list,
+			 * narrower conversions read its low bits.
+			 */
+			scnprintf(buf, sizeof(buf), fmt,
+				  log->args[0], log->args[1], log->args[2],
+				  log->args[3], log->args[4], log->args[5]);
+			dbg_snapshot_get_sec(log->time, &sec, &msec);
+			pr_info("cpu%d: %10lu.%06lu sec, %s", cpu, sec, msec, buf);
+		}
+	}
+}
+
 #ifndef arch_irq_stat
 #define arch_irq_stat() 0
 #endif
@@ -807,6 +902,7 @@ void dbg_snapshot_print_log_report(void)
 	pr_info("==========================================================\n");
 	dbg_snapshot_print_lastinfo();
 	dbg_snapshot_print_freqinfo();
+	dbg_snapshot_print_printk_bin();
 	dbg_snapshot_print_irq();
 	pr_info("==========================================================\n");
 }
@@ -837,6 +933,7 @@ void dbg_snapshot_init_log(void)
 	log_item_set_filed(THERMAL, thermal);
 	log_item_set_filed(ACPM, acpm);
 	log_item_set_filed(PRINTK, print);
+	log_item_set_filed(PRINTK_BIN, print_bin);
 }
 
 void dbg_snapshot_register_vh_log(void)
@@ -853,6 +950,11 @@ void dbg_snapshot_register_vh_log(void)
 		if (register_trace_workqueue_execute_end(dbg_snapshot_wq_end, NULL))
 			pr_err("dss wq end log VH register failed\n");
 	}
+
+	if (dss_log_items[DSS_LOG_PRINTK_BIN_ID].entry.enabled) {
+		if (register_module_notifier(&dss_print_bin_module_nb))
+			pr_err("dss printk bin module notifier register failed\n");
+	}
 }
 
 void dbg_snapshot_start_log(void)
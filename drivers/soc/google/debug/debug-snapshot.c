@@ -400,8 +400,19 @@ static void dbg_snapshot_fixmap(void)
 		}
 	}
 
-	if (dss_items[DSS_ITEM_KEVENTS_ID].entry.enabled)
-		dss_log = (struct dbg_snapshot_log *)(dss_items[DSS_ITEM_KEVENTS_ID].entry.vaddr);
+	if (dss_items[DSS_ITEM_KEVENTS_ID].entry.enabled) {
+		/*  the log is laid over the reservation, it must not run past it */
+		if (dss_items[DSS_ITEM_KEVENTS_ID].entry.size <
+				sizeof(struct dbg_snapshot_log)) {
+			dev_err(dss_desc.dev, "log_kevents: 0x%zx < 0x%zx, disabled\n",
+				dss_items[DSS_ITEM_KEVENTS_ID].entry.size,
+				sizeof(struct dbg_snapshot_log));
+			dss_items[DSS_ITEM_KEVENTS_ID].entry.enabled = false;
+		} else {
+			dss_log = (struct dbg_snapshot_log *)
+				(dss_items[DSS_ITEM_KEVENTS_ID].entry.vaddr);
+		}
+	}
 	if (dss_items[DSS_ITEM_ITMON_ID].entry.enabled) {
 		dss_itmon = (struct itmon_logs *)(dss_items[DSS_ITEM_ITMON_ID].entry.vaddr);
 		dss_itmon->magic = DSS_ITMON_MAGIC_INITIALIZED;
@@ -121,6 +121,9 @@ struct power_mode {
 	/* disable count */
 	atomic_t	disable;
 
+	/* bitmask of siblings in IDLE state, updated without cpupm_lock */
+	atomic_long_t	idle_cpus;
+
 	/*
 	 * device attribute for sysfs,
 	 * it supports for enabling or disabling this power mode
@@ -246,6 +249,9 @@ static DEFINE_SPINLOCK(idle_ip_lock);
 
 static LIST_HEAD(ip_list);
 
+/* number of normal idle-ips in busy state, read without idle_ip_lock */
+static atomic_t idle_ip_busy_count = ATOMIC_INIT(0);
+
 #define NORMAL_IP	0
 #define EXTERN_IP	1
 static bool __ip_busy(struct idle_ip *ip)
@@ -322,6 +328,14 @@ void exynos_update_ip_idle_status(int index, int idle)
 		return;
 	}
 
+	if (ip->type == NORMAL_IP &&
+	    (ip->idle == CPUPM_STATE_BUSY) != (idle == CPUPM_STATE_BUSY)) {
+		if (idle == CPUPM_STATE_BUSY)
+			atomic_inc(&idle_ip_busy_count);
+		else
+			atomic_dec(&idle_ip_busy_count);
+	}
+
 	ip->idle = idle;
 	spin_unlock_irqrestore(&idle_ip_lock, flags);
 }
@@ -350,6 +364,8 @@ int exynos_get_idle_ip_index(const char *name)
 	ip->name = name;
 	ip->index = new_index;
 	ip->type = NORMAL_IP;
+	ip->idle = CPUPM_STATE_BUSY;
+	atomic_inc(&idle_ip_busy_count);
 	list_add_tail(&ip->list, &ip_list);
 
 	spin_unlock_irqrestore(&idle_ip_lock, flags);
@@ -648,6 +664,14 @@ static DEVICE_ATTR_RW(profile);
  */
 static spinlock_t cpupm_lock;
 
+/*
+ * Each power mode keeps a bitmask of its idle siblings. A cpu entering idle
+ * takes cpupm_lock only when it may be able to enter one of its power modes,
+ * i.e. it completes the idle bitmask of the domain. The full checks are still
+ * done by entry_allow() under cpupm_lock.
+ */
+static bool cpupm_fast_entry;
+
 static void awake_cpus(const struct cpumask *cpus)
 {
 	int cpu;
@@ -829,6 +853,72 @@ static bool entry_allow(int cpu, struct power_mode *mode)
 	return true;
 }
 
+/*
+ * Mark the cpu idle in the bitmask of its power modes and return whether
+ * any of them may be entered now. It never misses a power mode entry_allow()
+ * would allow, the cpu completing the idle bitmask of a domain sees it.
+ */
+static bool entry_candidate(int cpu, struct exynos_cpupm *pm)
+{
+	unsigned long bit = BIT(cpu);
+	unsigned long online = cpumask_bits(cpu_online_mask)[0];
+	s64 sleep_length;
+	bool candidate = false;
+	int i;
+
+	if (!cpupm_fast_entry)
+		return true;
+
+	sleep_length = get_sleep_length(cpu, ktime_get());
+
+	for (i = 0; i < POWERMODE_TYPE_END; i++) {
+		struct power_mode *mode = pm->modes[i];
+		unsigned long siblings, idle;
+
+		if (!mode)
+			continue;
+
+		/* fully ordered after set_state_idle(pm) and next_hrtimer */
+		idle = atomic_long_fetch_or(bit, &mode->idle_cpus) | bit;
+
+		if (candidate)
+			continue;
+
+		if (atomic_read(&mode->disable))
+			continue;
+
+		if (!cpumask_test_cpu(cpu, &mode->entry_allowed))
+			continue;
+
+		siblings = cpumask_bits(&mode->siblings)[0] & online;
+		if ((idle & siblings) != siblings)
+			continue;
+
+		if (sleep_length < mode->target_residency)
+			continue;
+
+		if (mode->type == POWERMODE_TYPE_SYSTEM &&
+		    atomic_read(&idle_ip_busy_count))
+			continue;
+
+		candidate = true;
+	}
+
+	return candidate;
+}
+
+static void clear_idle_cpus(int cpu, struct exynos_cpupm *pm)
+{
+	int i;
+
+	if (!cpupm_fast_entry)
+		return;
+
+	for (i = 0; i < POWERMODE_TYPE_END; i++)
+		if (pm->modes[i])
+			atomic_long_andnot(BIT(cpu), &pm->modes[i]->idle_cpus);
+}
+
 static void set_wakeup_mask(void)
 {
 	int i;
@@ -923,7 +1013,6 @@ static void exynos_cpupm_enter(int cpu)
 	struct exynos_cpupm *pm;
 	int i;
 
-	spin_lock(&cpupm_lock);
 	pm = per_cpu_ptr(cpupm, cpu);
 
 	/* Configure PMUCAL to power down core */
@@ -933,6 +1022,12 @@ static void exynos_cpupm_enter(int cpu)
 	dbg_snapshot_cpuidle_mod("c2", 0, 0, DSS_FLAG_IN);
 	set_state_idle(pm);
 
+	/* Most of the time no power mode is eligible, skip the lock */
+	if (!entry_candidate(cpu, pm))
+		return;
+
+	spin_lock(&cpupm_lock);
+
 	/* Try to enter power mode */
 	for (i = 0; i < POWERMODE_TYPE_END; i++) {
 		struct power_mode *mode = pm->modes[i];
@@ -940,6 +1035,13 @@ static void exynos_cpupm_enter(int cpu)
 		if (!mode)
 			continue;
 
+		/*
+		 * The cpu state is set outside the lock, so two cpus may both
+		 * see the mode complete. Only the first one enters it.
+		 */
+		if (check_state_idle(mode))
+			continue;
+
 		if (entry_allow(cpu, mode))
 			enter_power_mode(cpu, mode);
 	}
@@ -952,8 +1054,14 @@ static void exynos_cpupm_exit(int cpu, int cancel)
 	struct exynos_cpupm *pm;
 	int i;
 
-	spin_lock(&cpupm_lock);
 	pm = per_cpu_ptr(cpupm, cpu);
+	clear_idle_cpus(cpu, pm);
+
+	/*
+	 * Exit always takes the lock, a sibling may be entering a power mode
+	 * containing this cpu right now.
+	 */
+	spin_lock(&cpupm_lock);
 
 	/* Make settings to exit from mode */
 	for (i = 0; i < POWERMODE_TYPE_END; i++) {
@@ -1498,6 +1606,9 @@ static int exynos_cpupm_probe(struct platform_device *pdev)
 
 	spin_lock_init(&cpupm_lock);
 
+	/* idle bitmasks of power modes hold cpus in a single long */
+	cpupm_fast_entry = nr_cpu_ids <= BITS_PER_LONG;
+
 	nscode_base = ioremap(NSCODE_BASE, SZ_4K);
 
 	system_rebooting = false;
@@ -90,9 +90,33 @@ struct gcma_area {
 
 static struct gcma_area areas[MAX_GCMA_AREAS];
 
+/*
+ * Area ids sorted by start_pfn. Areas are registered while reserved memory
+ * is set up, before any of their ranges is handed back by gcma_free_range.
+ */
+static int sorted_area_ids[MAX_GCMA_AREAS];
+static int nr_sorted_areas;
+static DEFINE_SPINLOCK(area_index_lock);
+
+static void index_gcma_area(int area_id)
+{
+	unsigned long start_pfn = areas[area_id].start_pfn;
+	int i;
+
+	spin_lock(&area_index_lock);
+	for (i = nr_sorted_areas; i > 0; i--) {
+		if (areas[sorted_area_ids[i - 1]].start_pfn < start_pfn)
+			break;
+		sorted_area_ids[i] = sorted_area_ids[i - 1];
+	}
+	sorted_area_ids[i] = area_id;
+	smp_store_release(&nr_sorted_areas, nr_sorted_areas + 1);
+	spin_unlock(&area_index_lock);
+}
+
 static int lookup_area_id(struct page *page, int start_id)
 {
-	int id, nr_area;
+	int lo, hi, nr_area;
 	unsigned long pfn = page_to_pfn(page);
 	struct gcma_area *area;
 
@@ -100,10 +124,19 @@ static int lookup_area_id(struct page *page, int start_id)
 	if (pfn >= area->start_pfn && pfn <= area->end_pfn)
 		return start_id;
 
-	nr_area = atomic_read(&nr_gcma_area);
-	for (id = 0; id < nr_area; id++) {
+	nr_area = smp_load_acquire(&nr_sorted_areas);
+	lo = 0;
+	hi = nr_area - 1;
+	while (lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+		int id = sorted_area_ids[mid];
+
 		area = &areas[id];
-		if (pfn >= area->start_pfn && pfn <= area->end_pfn)
+		if (pfn < area->start_pfn)
+			hi = mid - 1;
+		else if (pfn > area->end_pfn)
+			lo = mid + 1;
+		else
 			return id;
 	}
 
@@ -134,24 +167,110 @@ struct gcma_inode {
 
 static struct kmem_cache *slab_gcma_inode;
 
-static void add_page_to_lru(struct page *page)
+/*
+ * LRU additions and rotations are batched per-cpu and spliced into
+ * gcma_lru under lru_lock in bulk. A page in a batch holds a reference
+ * so it cannot be freed before the batch is drained.
+ */
+#define GCMA_LRU_BATCH	15
+
+struct gcma_lru_batch {
+	unsigned int nr;
+	struct page *pages[GCMA_LRU_BATCH];
+};
+
+struct gcma_lru_pvecs {
+	spinlock_t lock;
+	struct gcma_lru_batch add;
+	struct gcma_lru_batch rotate;
+};
+
+static DEFINE_PER_CPU(struct gcma_lru_pvecs, gcma_lru_pvecs) = {
+	.lock = __SPIN_LOCK_UNLOCKED(gcma_lru_pvecs.lock),
+};
+
+static inline void gcma_get_page(struct page *page);
+static void gcma_put_page(struct page *page);
+
+/* Hold pvecs->lock */
+static void __drain_lru_pvecs(struct gcma_lru_pvecs *pvecs)
 {
-	VM_BUG_ON(!irqs_disabled());
-	VM_BUG_ON(!list_empty(&page->lru));
+	struct page *pages[GCMA_LRU_BATCH * 2];
+	unsigned int i, nr = 0;
+
+	if (!pvecs->add.nr && !pvecs->rotate.nr)
+		return;
 
 	spin_lock(&lru_lock);
-	list_add(&page->lru, &gcma_lru);
+	for (i = 0; i < pvecs->add.nr; i++) {
+		struct page *page = pvecs->add.pages[i];
+
+		if (list_empty(&page->lru))
+			list_add(&page->lru, &gcma_lru);
+		pages[nr++] = page;
+	}
+
+	for (i = 0; i < pvecs->rotate.nr; i++) {
+		struct page *page = pvecs->rotate.pages[i];
+
+		if (!list_empty(&page->lru))
+			list_move(&page->lru, &gcma_lru);
+		pages[nr++] = page;
+	}
 	spin_unlock(&lru_lock);
+
+	pvecs->add.nr = 0;
+	pvecs->rotate.nr = 0;
+
+	/* May free pages, which takes lru_lock again */
+	for (i = 0; i < nr; i++)
+		gcma_put_page(pages[i]);
 }
 
-static void rotate_lru_page(struct page *page)
+static void drain_lru_pvecs_cpu(int cpu)
 {
+	struct gcma_lru_pvecs *pvecs = per_cpu_ptr(&gcma_lru_pvecs, cpu);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pvecs->lock, flags);
+	__drain_lru_pvecs(pvecs);
+	spin_unlock_irqrestore(&pvecs->lock, flags);
+}
+
+static void drain_all_lru_pvecs(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		drain_lru_pvecs_cpu(cpu);
+}
+
+static void lru_pvecs_add(struct page *page, bool rotate)
+{
+	struct gcma_lru_pvecs *pvecs = this_cpu_ptr(&gcma_lru_pvecs);
+	struct gcma_lru_batch *batch;
+
 	VM_BUG_ON(!irqs_disabled());
 
-	spin_lock(&lru_lock);
-	if (!list_empty(&page->lru))
-		list_move(&page->lru, &gcma_lru);
-	spin_unlock(&lru_lock);
+	gcma_get_page(page);
+	spin_lock(&pvecs->lock);
+	batch = rotate ? &pvecs->rotate : &pvecs->add;
+	batch->pages[batch->nr++] = page;
+	if (batch->nr == GCMA_LRU_BATCH)
+		__drain_lru_pvecs(pvecs);
+	spin_unlock(&pvecs->lock);
+}
+
+static void add_page_to_lru(struct page *page)
+{
+	VM_BUG_ON(!list_empty(&page->lru));
+
+	lru_pvecs_add(page, false);
+}
+
+static void rotate_lru_page(struct page *page)
+{
+	lru_pvecs_add(page, true);
 }
 
 static void delete_page_from_lru(struct page *page)
@@ -319,6 +438,7 @@ int register_gcma_area(const char *name, phys_addr_t base, phys_addr_t size)
 
 	area->start_pfn = pfn;
 	area->end_pfn = pfn + page_count - 1;
+	index_gcma_area(area_id);
 	inc_gcma_total_pages(page_count);
 
 	pr_info("Reserved memory: created GCMA memory pool at %pa, size %lu MiB for %s\n",
@@ -565,6 +685,8 @@ again:
 		if (!page_ref_freeze(page, 2)) {
 			xa_unlock(&inode->pages);
 			gcma_put_page(page);
+			/* The extra reference may be a pending LRU batch */
+			drain_all_lru_pvecs();
 			goto again;
 		}
 
@@ -591,6 +713,7 @@ void gcma_alloc_range(unsigned long start_pfn, unsigned long end_pfn)
 
 	trace_gcma_alloc_start(start_pfn, count);
 	start_time = ktime_to_ns(ktime_get());
+	drain_all_lru_pvecs();
 	for (i = 0; i < nr_area; i++) {
 		unsigned long s_pfn, e_pfn;
 
@@ -654,6 +777,8 @@ void evict_gcma_lru_pages(unsigned long nr_request)
 {
 	unsigned long nr_evicted = 0;
 
+	drain_all_lru_pvecs();
+
 	while (nr_request) {
 		struct page *pages[MAX_EVICT_BATCH];
 		int i;
@@ -902,6 +1027,8 @@ retry:
 
 	if (!try_empty_inode(inode)) {
 		put_gcma_inode(inode);
+		/* Erased pages may still be pinned by LRU batches */
+		drain_all_lru_pvecs();
 		goto retry;
 	}
 
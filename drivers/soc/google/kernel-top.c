@@ -6,24 +6,76 @@
 
 #define dev_fmt(fmt)	"TOP: " fmt
 
+#include <linux/hash.h>
 #include <linux/kernel_stat.h>
 #include <linux/module.h>
 #include <linux/nmi.h>
 #include <linux/platform_device.h>
 #include <linux/rtc.h>
 #include <linux/sched.h>
+#include <linux/sched/clock.h>
 #include <linux/slab.h>
 #include <linux/threads.h>
 #include <linux/tick.h>
 #include <linux/time.h>
+#include <linux/tracepoint.h>
+#include <linux/vmalloc.h>
 #include <asm/irq_regs.h>
 #include <linux/kernel-top.h>
 #include <linux/sched/cputime.h>
 #include <linux/sched/debug.h>
 #include <linux/sched/signal.h>
+#include <trace/events/sched.h>
 
 #define NUM_BUSY_TASK_CHECK 5
 
+/*
+ * Continuous sampling: every cpu charges the time between two context
+ * switches to the process that ran, in a small pid-hashed table per time
+ * window, and keeps the top NUM_BUSY_TASK_CHECK processes in a min-heap.
+ * A snapshot only merges the heaps of the current and previous windows.
+ */
+#define KTOP_HASH_BITS		8
+#define KTOP_HASH_SIZE		(1 << KTOP_HASH_BITS)
+#define KTOP_HASH_MAX_PROBE	16
+#define KTOP_WINDOW_NS		NSEC_PER_SEC
+/* windows started earlier than this are too old for a snapshot */
+#define KTOP_STALE_NS		(2 * KTOP_WINDOW_NS)
+#define KTOP_NOT_IN_HEAP	U16_MAX
+/* both heaps and the running task of every cpu */
+#define KTOP_MERGE_PER_CPU	(NUM_BUSY_TASK_CHECK * 2 + 1)
+
+struct ktop_slot {
+	u32 gen;
+	pid_t tgid;
+	u64 runtime;
+	u16 heap_idx;
+	char comm[TASK_COMM_LEN];
+};
+
+struct ktop_window {
+	u64 start;
+	u32 gen;
+	int nr_heap;
+	u16 heap[NUM_BUSY_TASK_CHECK];
+	struct ktop_slot slots[KTOP_HASH_SIZE];
+};
+
+struct ktop_cpu {
+	raw_spinlock_t lock;
+	struct task_struct *curr;
+	u64 last_switch;
+	int cur;
+	struct ktop_window win[2];
+} ____cacheline_aligned;
+
+static struct ktop_cpu *ktop_cpus;
+static DEFINE_MUTEX(ktop_sampler_mutex);
+/* protects ktop_cpus against the sampler stop and the merge buffer */
+static DEFINE_SPINLOCK(ktop_snapshot_lock);
+static struct kernel_top_entry *ktop_merge;
+static bool continuous;
+
 struct kernel_top_context {
 	struct device *owner;
 	u64 *prev_tasktics_array;
@@ -35,6 +87,7 @@ struct kernel_top_context {
 	struct kernel_cpustat prev_all_cpustat;
 	u64 frame_cpustat_total;
 	bool kernel_top_alloc_done;
+	bool continuous;
 };
 
 /* Clone from fs/proc/stat.c. */
@@ -196,6 +249,342 @@ static u64 cal_frame_cpustat_total(struct kernel_cpustat curr_all_cpustat,
 	return (user_time + system_time + io_time + irq_time + idle_time);
 }
 
+static inline u64 ktop_heap_runtime(struct ktop_window *win, int i)
+{
+	return win->slots[win->heap[i]].runtime;
+}
+
+static void ktop_heap_swap(struct ktop_window *win, int a, int b)
+{
+	swap(win->heap[a], win->heap[b]);
+	win->slots[win->heap[a]].heap_idx = a;
+	win->slots[win->heap[b]].heap_idx = b;
+}
+
+static void ktop_heap_up(struct ktop_window *win, int i)
+{
+	while (i) {
+		int parent = (i - 1) / 2;
+
+		if (ktop_heap_runtime(win, parent) <= ktop_heap_runtime(win, i))
+			break;
+		ktop_heap_swap(win, parent, i);
+		i = parent;
+	}
+}
+
+static void ktop_heap_down(struct ktop_window *win, int i)
+{
+	for (;;) {
+		int l = 2 * i + 1, r = l + 1, min = i;
+
+		if (l < win->nr_heap &&
+		    ktop_heap_runtime(win, l) < ktop_heap_runtime(win, min))
+			min = l;
+		if (r < win->nr_heap &&
+		    ktop_heap_runtime(win, r) < ktop_heap_runtime(win, min))
+			min = r;
+		if (min == i)
+			break;
+		ktop_heap_swap(win, min, i);
+		i = min;
+	}
+}
+
+/* The runtime of slot idx only grows, so it can only sink in the min-heap. */
+static void ktop_heap_update(struct ktop_window *win, u16 idx)
+{
+	struct ktop_slot *slot = &win->slots[idx];
+
+	if (slot->heap_idx != KTOP_NOT_IN_HEAP) {
+		ktop_heap_down(win, slot->heap_idx);
+	} else if (win->nr_heap < NUM_BUSY_TASK_CHECK) {
+		slot->heap_idx = win->nr_heap;
+		win->heap[win->nr_heap++] = idx;
+		ktop_heap_up(win, slot->heap_idx);
+	} else if (slot->runtime > ktop_heap_runtime(win, 0)) {
+		win->slots[win->heap[0]].heap_idx = KTOP_NOT_IN_HEAP;
+		win->heap[0] = idx;
+		slot->heap_idx = 0;
+		ktop_heap_down(win, 0);
+	}
+}
+
+static struct ktop_slot *ktop_find_slot(struct ktop_window *win,
+					struct task_struct *p, u16 *pidx)
+{
+	u32 idx = hash_32(p->tgid, KTOP_HASH_BITS);
+	int i;
+
+	for (i = 0; i < KTOP_HASH_MAX_PROBE; i++) {
+		struct ktop_slot *slot = &win->slots[idx];
+
+		if (slot->gen != win->gen) {
+			slot->gen = win->gen;
+			slot->tgid = p->tgid;
+			slot->runtime = 0;
+			slot->heap_idx = KTOP_NOT_IN_HEAP;
+			memcpy(slot->comm, p->group_leader->comm, TASK_COMM_LEN);
+			*pidx = idx;
+			return slot;
+		}
+
+		if (slot->tgid == p->tgid) {
+			*pidx = idx;
+			return slot;
+		}
+
+		idx = (idx + 1) & (KTOP_HASH_SIZE - 1);
+	}
+
+	return NULL;
+}
+
+static void ktop_sched_switch(void *data, bool preempt,
+			      struct task_struct *prev,
+			      struct task_struct *next,
+			      unsigned int prev_state)
+{
+	struct ktop_cpu *kc = &ktop_cpus[smp_processor_id()];
+	struct ktop_window *win;
+	struct ktop_slot *slot;
+	u64 now = local_clock();
+	u64 delta;
+	u16 idx;
+
+	raw_spin_lock(&kc->lock);
+
+	delta = kc->last_switch ? now - kc->last_switch : 0;
+	kc->last_switch = now;
+	kc->curr = next;
+
+	win = &kc->win[kc->cur];
+	if (now - win->start >= KTOP_WINDOW_NS) {
+		u32 gen = win->gen;
+
+		kc->cur ^= 1;
+		win = &kc->win[kc->cur];
+		win->start = now;
+		win->gen = gen + 1;
+		win->nr_heap = 0;
+	}
+
+	if (!delta || is_idle_task(prev))
+		goto out;
+
+	/* too many processes in this window, drop the sample */
+	slot = ktop_find_slot(win, prev, &idx);
+	if (!slot)
+		goto out;
+
+	slot->runtime += delta;
+	ktop_heap_update(win, idx);
+out:
+	raw_spin_unlock(&kc->lock);
+}
+
+static void ktop_merge_add(pid_t tgid, const char *comm, u64 runtime, int *nr)
+{
+	int i;
+
+	for (i = 0; i < *nr; i++) {
+		if (ktop_merge[i].pid == tgid)
+			break;
+	}
+
+	if (i == *nr) {
+		ktop_merge[i].pid = tgid;
+		ktop_merge[i].runtime = 0;
+		memcpy(ktop_merge[i].comm, comm, TASK_COMM_LEN);
+		(*nr)++;
+	}
+	ktop_merge[i].runtime += runtime;
+}
+
+static void ktop_merge_window(struct ktop_window *win, int *nr)
+{
+	int i;
+
+	for (i = 0; i < win->nr_heap; i++) {
+		struct ktop_slot *slot = &win->slots[win->heap[i]];
+
+		ktop_merge_add(slot->tgid, slot->comm, slot->runtime, nr);
+	}
+}
+
+/**
+ * kernel_top_snapshot - copy the busiest processes of the recent windows
+ * @top: output array, sorted by runtime
+ * @n: size of @top
+ * @total: sum of the sampled time of all cpus, may be NULL
+ *
+ * Returns the number of entries filled, 0 if continuous sampling is off.
+ */
+int kernel_top_snapshot(struct kernel_top_entry *top, int n, u64 *total)
+{
+	u64 now = local_clock(), span = 0;
+	unsigned long flags;
+	int cpu, i, j, nr = 0;
+
+	spin_lock_irqsave(&ktop_snapshot_lock, flags);
+
+	if (!ktop_cpus) {
+		spin_unlock_irqrestore(&ktop_snapshot_lock, flags);
+		return 0;
+	}
+
+	for_each_online_cpu(cpu) {
+		struct ktop_cpu *kc = &ktop_cpus[cpu];
+		struct ktop_window *cur, *prev;
+		u64 cpu_span, running;
+
+		raw_spin_lock(&kc->lock);
+		if (!kc->last_switch) {
+			raw_spin_unlock(&kc->lock);
+			continue;
+		}
+
+		/*
+		 * Windows only rotate on a context switch, a cpu idle for long
+		 * still holds old ones. Skip those and count each window for
+		 * at most its length.
+		 */
+		cpu_span = 0;
+		cur = &kc->win[kc->cur];
+		prev = &kc->win[kc->cur ^ 1];
+		if (now - cur->start <= KTOP_STALE_NS) {
+			ktop_merge_window(cur, &nr);
+			cpu_span = min_t(u64, now - cur->start, KTOP_WINDOW_NS);
+
+			if (prev->start && prev->gen + 1 == cur->gen &&
+			    now - prev->start <= KTOP_STALE_NS) {
+				ktop_merge_window(prev, &nr);
+				cpu_span += min_t(u64, cur->start - prev->start,
+						  KTOP_WINDOW_NS);
+			}
+		}
+
+		/*
+		 * A task never switched out is not charged yet. It cannot exit
+		 * while its cpu waits for kc->lock in ktop_sched_switch().
+		 */
+		if (kc->curr && !is_idle_task(kc->curr)) {
+			running = min_t(u64, now - kc->last_switch, KTOP_WINDOW_NS);
+			ktop_merge_add(kc->curr->tgid, kc->curr->group_leader->comm,
+				       running, &nr);
+			cpu_span = max(cpu_span, running);
+		}
+		raw_spin_unlock(&kc->lock);
+
+		span += cpu_span;
+	}
+
+	/* partial selection sort, n is small */
+	n = min(n, nr);
+	for (i = 0; i < n; i++) {
+		int max = i;
+
+		for (j = i + 1; j < nr; j++) {
+			if (ktop_merge[j].runtime > ktop_merge[max].runtime)
+				max = j;
+		}
+		swap(ktop_merge[i], ktop_merge[max]);
+		top[i] = ktop_merge[i];
+	}
+
+	spin_unlock_irqrestore(&ktop_snapshot_lock, flags);
+
+	if (total)
+		*total = span;
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(kernel_top_snapshot);
+
+static int ktop_sampler_start(void)
+{
+	struct kernel_top_entry *merge;
+	struct ktop_cpu *cpus;
+	unsigned long flags;
+	int cpu, ret;
+
+	cpus = vzalloc(array_size(nr_cpu_ids, sizeof(*cpus)));
+	if (!cpus)
+		return -ENOMEM;
+
+	merge = vmalloc(array3_size(nr_cpu_ids, KTOP_MERGE_PER_CPU, sizeof(*merge)));
+	if (!merge) {
+		vfree(cpus);
+		return -ENOMEM;
+	}
+
+	for_each_possible_cpu(cpu)
+		raw_spin_lock_init(&cpus[cpu].lock);
+
+	spin_lock_irqsave(&ktop_snapshot_lock, flags);
+	ktop_cpus = cpus;
+	ktop_merge = merge;
+	spin_unlock_irqrestore(&ktop_snapshot_lock, flags);
+
+	ret = register_trace_sched_switch(ktop_sched_switch, NULL);
+	if (ret) {
+		spin_lock_irqsave(&ktop_snapshot_lock, flags);
+		ktop_cpus = NULL;
+		ktop_merge = NULL;
+		spin_unlock_irqrestore(&ktop_snapshot_lock, flags);
+		vfree(merge);
+		vfree(cpus);
+	}
+
+	return ret;
+}
+
+static void ktop_sampler_stop(void)
+{
+	struct kernel_top_entry *merge = ktop_merge;
+	struct ktop_cpu *cpus = ktop_cpus;
+	unsigned long flags;
+
+	unregister_trace_sched_switch(ktop_sched_switch, NULL);
+	tracepoint_synchronize_unregister();
+
+	spin_lock_irqsave(&ktop_snapshot_lock, flags);
+	ktop_cpus = NULL;
+	ktop_merge = NULL;
+	spin_unlock_irqrestore(&ktop_snapshot_lock, flags);
+
+	vfree(merge);
+	vfree(cpus);
+}
+
+static int continuous_set(const char *val, const struct kernel_param *kp)
+{
+	bool enable;
+	int ret;
+
+	ret = kstrtobool(val, &enable);
+	if (ret)
+		return ret;
+
+	mutex_lock(&ktop_sampler_mutex);
+	if (enable && !continuous)
+		ret = ktop_sampler_start();
+	else if (!enable && continuous)
+		ktop_sampler_stop();
+	if (!ret)
+		continuous = enable;
+	mutex_unlock(&ktop_sampler_mutex);
+
+	return ret;
+}
+
+static const struct kernel_param_ops continuous_ops = {
+	.set = continuous_set,
+	.get = param_get_bool,
+};
+module_param_cb(continuous, &continuous_ops, &continuous, 0644);
+MODULE_PARM_DESC(continuous, "Keep the top processes updated on every context switch");
+
 static void kernel_top_cal(struct kernel_top_context *cxt)
 {
 	int task_count = 0;
@@ -260,16 +649,35 @@ static void kernel_top_show(struct kernel_top_context *cxt)
 	memset(cxt->curr_task_pid_array, 0, sizeof(pid_t) * PID_MAX_DEFAULT);
 }
 
+static void kernel_top_show_sampled(struct kernel_top_context *cxt)
+{
+	struct kernel_top_entry top[NUM_BUSY_TASK_CHECK];
+	u64 total;
+	int i, n;
+
+	n = kernel_top_snapshot(top, NUM_BUSY_TASK_CHECK, &total);
+
+	dev_info(cxt->owner, "CPU Usage     PID     Name\n");
+	for (i = 0; i < n && total > 0; i++)
+		dev_info(cxt->owner, "%8llu%%%8d     %s%10llu\n",
+			 top[i].runtime * 100 / total, top[i].pid, top[i].comm,
+			 nsec_to_clock_t(top[i].runtime));
+}
+
 void kernel_top_print(struct kernel_top_context *cxt)
 {
 	struct timespec64 ts;
 	struct rtc_time tm;
 
-	if (cxt->kernel_top_alloc_done == false)
-		return;
+	if (cxt->continuous) {
+		kernel_top_show_sampled(cxt);
+	} else {
+		if (cxt->kernel_top_alloc_done == false)
+			return;
 
-	kernel_top_cal(cxt);
-	kernel_top_show(cxt);
+		kernel_top_cal(cxt);
+		kernel_top_show(cxt);
+	}
 
 	ktime_get_real_ts64(&ts);
 	rtc_time64_to_tm(ts.tv_sec - (sys_tz.tz_minuteswest * 60), &tm);
@@ -286,7 +694,10 @@ int kernel_top_init(struct device *dev, struct kernel_top_context **pcxt)
 	if (!cxt)
 		return -ENOMEM;
 
-	if (cxt->kernel_top_alloc_done == false) {
+	/* The sampler already has the statistic, skip the process walk. */
+	cxt->continuous = READ_ONCE(continuous);
+
+	if (!cxt->continuous && cxt->kernel_top_alloc_done == false) {
 
 		cxt->prev_tasktics_array =
 			vmalloc(sizeof(u64) * PID_MAX_DEFAULT);
@@ -332,6 +743,11 @@ void kernel_top_reset(struct kernel_top_context *cxt)
 	struct timespec64 ts;
 	struct rtc_time tm;
 
+	if (cxt->continuous) {
+		dev_info(cxt->owner, "Kernel Top Statistic sampled continuously\n");
+		return;
+	}
+
 	memset(cxt->prev_tasktics_array, 0, sizeof(u64) * PID_MAX_DEFAULT);
 	memset(cxt->frame_tasktics_array, 0, sizeof(u64) * PID_MAX_DEFAULT);
 	memset(cxt->task_ptr_array, 0,
@@ -371,9 +787,21 @@ void kernel_top_destroy(struct kernel_top_context *cxt)
 
 		devm_kfree(cxt->owner, cxt);
 		cxt->kernel_top_alloc_done = false;
+	} else if (cxt->continuous) {
+		devm_kfree(cxt->owner, cxt);
 	}
 }
 EXPORT_SYMBOL_GPL(kernel_top_destroy);
 
+static void __exit kernel_top_exit(void)
+{
+	mutex_lock(&ktop_sampler_mutex);
+	if (continuous)
+		ktop_sampler_stop();
+	continuous = false;
+	mutex_unlock(&ktop_sampler_mutex);
+}
+module_exit(kernel_top_exit);
+
 MODULE_DESCRIPTION("Kernel-Top utils");
 MODULE_LICENSE("GPL v2");
@@ -8,7 +8,13 @@
 #include <linux/kthread.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/hashtable.h>
+#include <linux/oom.h>
+#include <linux/rculist.h>
 #include <uapi/linux/sched/types.h>
+#include <trace/events/oom.h>
+#include <trace/events/sched.h>
+#include <trace/events/task.h>
 #include <trace/hooks/systrace.h>
 
 #include "pa_kill_sysfs.h"
@@ -106,54 +112,304 @@ static int kill_task(struct task_struct *victim, struct mm_struct *mm)
 	return 0;
 }
 
-static struct task_struct *find_and_get_task(int min_oom_score_adj)
+/*
+ * Victim index: every process with a non-negative oom_score_adj sits on
+ * the list of its adj bucket. The index is kept up to date from the fork,
+ * oom_score_adj update and exit tracepoints so victim selection only needs
+ * to look at the highest populated buckets.
+ *
+ * Buckets are walked under RCU. A process that moves to another bucket
+ * gets a new node so a concurrent walker never crosses between lists.
+ */
+#define ADJ_BUCKET_SIZE		100
+#define NR_ADJ_BUCKETS		(OOM_SCORE_ADJ_MAX / ADJ_BUCKET_SIZE + 1)
+#define VICTIM_HASH_BITS	8
+
+struct pa_victim {
+	struct pid *pid;
+	int bucket;
+	struct list_head list;		/* adj bucket, RCU */
+	struct hlist_node hash;		/* keyed by pid, victim_index_lock */
+	struct rcu_head rcu;
+};
+
+static struct list_head adj_buckets[NR_ADJ_BUCKETS];
+static DEFINE_HASHTABLE(victim_hash, VICTIM_HASH_BITS);
+static DEFINE_SPINLOCK(victim_index_lock);
+static struct kmem_cache *pa_victim_cache;
+
+static inline int adj_to_bucket(int adj)
 {
-	struct task_struct *p, *victim = NULL;
-	long adj, victim_point = 0;
+	return adj / ADJ_BUCKET_SIZE;
+}
 
-	rcu_read_lock();
-	for_each_process(p) {
-		struct task_struct *task;
-		long point;
+static void pa_victim_free(struct rcu_head *rcu)
+{
+	struct pa_victim *v = container_of(rcu, struct pa_victim, rcu);
 
-		/* Unkillable task */
-		if (is_global_init(p))
-			continue;
+	put_pid(v->pid);
+	kmem_cache_free(pa_victim_cache, v);
+}
 
-		if (p->flags & PF_KTHREAD)
-			continue;
+/* Hold victim_index_lock */
+static struct pa_victim *lookup_victim(struct pid *pid)
+{
+	struct pa_victim *v;
 
-		task = pa_find_lock_task_mm(p);
-		if (!task)
-			continue;
+	hash_for_each_possible(victim_hash, v, hash, (unsigned long)pid) {
+		if (v->pid == pid)
+			return v;
+	}
+
+	return NULL;
+}
 
-		adj = (long)task->signal->oom_score_adj;
+/* Hold victim_index_lock */
+static void __remove_victim(struct pa_victim *v)
+{
+	hash_del(&v->hash);
+	list_del_rcu(&v->list);
+	call_rcu(&v->rcu, pa_victim_free);
+}
 
-		/*
-		 * Check if the task was already being killed.
-		 */
-		if (adj < min_oom_score_adj ||
-		    test_bit(MMF_OOM_SKIP, &task->mm->flags) ||
-		    test_bit(MMF_UNSTABLE, &task->mm->flags) ||
-		    in_vfork(task)) {
-			task_unlock(task);
-			continue;
+static void __update_victim(struct task_struct *p, int adj)
+{
+	struct pid *pid = task_tgid(p);
+	struct pa_victim *old, *v = NULL;
+	unsigned long flags;
+
+	if (p->flags & (PF_KTHREAD | PF_EXITING) || is_global_init(p))
+		return;
+
+	if (adj >= 0) {
+		v = kmem_cache_alloc(pa_victim_cache, GFP_ATOMIC | __GFP_NOWARN);
+		if (v) {
+			v->pid = get_pid(pid);
+			v->bucket = adj_to_bucket(adj);
 		}
+	}
+
+	spin_lock_irqsave(&victim_index_lock, flags);
+	/*
+	 * pa_sched_process_exit() drops the process under this lock once
+	 * signal->live hits zero, so checking it here means a dying process
+	 * is never put back after it was removed.
+	 */
+	if (v && !atomic_read(&p->signal->live)) {
+		spin_unlock_irqrestore(&victim_index_lock, flags);
+		put_pid(v->pid);
+		kmem_cache_free(pa_victim_cache, v);
+		return;
+	}
+
+	old = lookup_victim(pid);
+	if (old && v && old->bucket == v->bucket) {
+		/* Stays in the same bucket, nothing to do */
+		spin_unlock_irqrestore(&victim_index_lock, flags);
+		put_pid(v->pid);
+		kmem_cache_free(pa_victim_cache, v);
+		return;
+	}
+
+	if (old)
+		__remove_victim(old);
+	if (v) {
+		hash_add(victim_hash, &v->hash, (unsigned long)pid);
+		list_add_tail_rcu(&v->list, &adj_buckets[v->bucket]);
+	}
+	spin_unlock_irqrestore(&victim_index_lock, flags);
+}
+
+static void update_victim(struct task_struct *p)
+{
+	__update_victim(p, READ_ONCE(p->signal->oom_score_adj));
+}
+
+static void remove_victim(struct task_struct *p)
+{
+	struct pa_victim *v;
+	unsigned long flags;
+
+	spin_lock_irqsave(&victim_index_lock, flags);
+	v = lookup_victim(task_tgid(p));
+	if (v)
+		__remove_victim(v);
+	spin_unlock_irqrestore(&victim_index_lock, flags);
+}
+
+static void pa_task_newtask(void *data, struct task_struct *p,
+			    unsigned long clone_flags)
+{
+	if (!(clone_flags & CLONE_THREAD))
+		update_victim(p);
+}
 
-		point = get_mm_counter(task->mm, MM_ANONPAGES) +
-			get_mm_counter(task->mm, MM_FILEPAGES) +
-			/* Consider compression ratio */
-			get_mm_counter(task->mm, MM_SWAPENTS) / SWAP_COMP_RATIO +
-			mm_pgtables_bytes(task->mm) / PAGE_SIZE;
+static bool pa_process_shares_mm(struct task_struct *p, struct mm_struct *mm)
+{
+	struct task_struct *t;
 
-		task_unlock(task); /* pair with pa_find_lock_task_mm */
+	for_each_thread(p, t) {
+		if (READ_ONCE(t->mm) == mm)
+			return true;
+	}
 
-		if (point > victim_point) {
-			if (victim)
-				put_task_struct(victim);
-			victim_point = point;
-			victim = task;
-			get_task_struct(victim);
+	return false;
+}
+
+static void pa_oom_score_adj_update(void *data, struct task_struct *p)
+{
+	int adj = READ_ONCE(p->signal->oom_score_adj);
+	struct mm_struct *mm = NULL;
+	struct task_struct *t;
+
+	update_victim(p);
+
+	/*
+	 * __set_oom_adj() copies the new value to the other processes sharing
+	 * the mm only after this tracepoint and without one of their own, so
+	 * move them to the new bucket here, the same way it picks them.
+	 */
+	if (p->vfork_done)
+		return;
+
+	t = pa_find_lock_task_mm(p);
+	if (!t)
+		return;
+	if (test_bit(MMF_MULTIPROCESS, &t->mm->flags)) {
+		mm = t->mm;
+		mmgrab(mm);
+	}
+	task_unlock(t);
+
+	if (!mm)
+		return;
+
+	rcu_read_lock();
+	for_each_process(t) {
+		if (same_thread_group(p, t) || t->vfork_done)
+			continue;
+		if (pa_process_shares_mm(t, mm))
+			__update_victim(t, adj);
+	}
+	rcu_read_unlock();
+	mmdrop(mm);
+}
+
+static void pa_sched_process_exit(void *data, struct task_struct *p)
+{
+	/* Only once the whole thread group is gone */
+	if (!atomic_read(&p->signal->live))
+		remove_victim(p);
+}
+
+static int victim_index_init(void)
+{
+	struct task_struct *p;
+	int i, ret;
+
+	pa_victim_cache = KMEM_CACHE(pa_victim, 0);
+	if (!pa_victim_cache)
+		return -ENOMEM;
+
+	for (i = 0; i < NR_ADJ_BUCKETS; i++)
+		INIT_LIST_HEAD(&adj_buckets[i]);
+
+	ret = register_trace_task_newtask(pa_task_newtask, NULL);
+	if (ret)
+		goto err_newtask;
+
+	ret = register_trace_oom_score_adj_update(pa_oom_score_adj_update, NULL);
+	if (ret)
+		goto err_adj_update;
+
+	ret = register_trace_sched_process_exit(pa_sched_process_exit, NULL);
+	if (ret)
+		goto err_exit;
+
+	/* Seed with the processes which were alive before the hooks */
+	rcu_read_lock();
+	for_each_process(p)
+		update_victim(p);
+	rcu_read_unlock();
+
+	return 0;
+
+err_exit:
+	unregister_trace_oom_score_adj_update(pa_oom_score_adj_update, NULL);
+err_adj_update:
+	unregister_trace_task_newtask(pa_task_newtask, NULL);
+err_newtask:
+	kmem_cache_destroy(pa_victim_cache);
+	return ret;
+}
+
+/*
+ * Pick the process with the most memory from the highest adj bucket that
+ * has an eligible process.
+ */
+static struct task_struct *find_and_get_task(int min_oom_score_adj)
+{
+	struct task_struct *p, *victim = NULL;
+	struct pa_victim *v;
+	long adj, victim_point = 0;
+	int bucket, min_bucket;
+
+	/* killable_min_oom_adj comes from sysfs unchecked */
+	min_oom_score_adj = clamp(min_oom_score_adj, OOM_SCORE_ADJ_MIN,
+				  OOM_SCORE_ADJ_MAX);
+	/* Only non-negative adjs are indexed */
+	min_bucket = adj_to_bucket(max(min_oom_score_adj, 0));
+
+	rcu_read_lock();
+	for (bucket = NR_ADJ_BUCKETS - 1;
+	     bucket >= min_bucket && !victim; bucket--) {
+		list_for_each_entry_rcu(v, &adj_buckets[bucket], list) {
+			struct task_struct *task;
+			long point;
+
+			p = pid_task(v->pid, PIDTYPE_TGID);
+			if (!p)
+				continue;
+
+			/* Unkillable task */
+			if (is_global_init(p))
+				continue;
+
+			if (p->flags & PF_KTHREAD)
+				continue;
+
+			task = pa_find_lock_task_mm(p);
+			if (!task)
+				continue;
+
+			adj = (long)task->signal->oom_score_adj;
+
+			/*
+			 * Check if the task was already being killed.
+			 */
+			if (adj < min_oom_score_adj ||
+			    test_bit(MMF_OOM_SKIP, &task->mm->flags) ||
+			    test_bit(MMF_UNSTABLE, &task->mm->flags) ||
+			    in_vfork(task)) {
+				task_unlock(task);
+				continue;
+			}
+
+			point = get_mm_counter(task->mm, MM_ANONPAGES) +
+				get_mm_counter(task->mm, MM_FILEPAGES) +
+				/* Consider compression ratio */
+				get_mm_counter(task->mm, MM_SWAPENTS) / SWAP_COMP_RATIO +
+				mm_pgtables_bytes(task->mm) / PAGE_SIZE;
+
+			task_unlock(task); /* pair with pa_find_lock_task_mm */
+
+			if (point > victim_point) {
+				if (victim)
+					put_task_struct(victim);
+				victim_point = point;
+				victim = task;
+				get_task_struct(victim);
+			}
 		}
 	}
 	rcu_read_unlock();
@@ -452,6 +708,12 @@ int __init pa_kill_init(void)
 {
 	int err;
 
+	err = victim_index_init();
+	if (err) {
+		pr_err("couldn't set up victim index %d\n", err);
+		return err;
+	}
+
 	/* enable threads on every core by default */
 	cpumask_setall(&pa_task_cpu_affinity);
 	/* no need a sysfs_lock since sysfs isn't populated yet */
@@ -11,9 +11,14 @@
  * GNU General Public License for more details.
  */
 #include <linux/cpu.h>
+#include <linux/cred.h>
 #include <linux/debugfs.h>
+#include <linux/hash.h>
 #include <linux/kobject.h>
 #include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/trace_events.h>
 #include <linux/tracepoint.h>
@@ -24,6 +29,7 @@
 #include "perf_trace_counters.h"
 
 static unsigned int tp_pid_state;
+static bool tp_aggregate;
 
 DEFINE_PER_CPU(u32, cntenset_val);
 DEFINE_PER_CPU(u64[NUM_EVENTS], previous_cnts);
@@ -57,6 +63,31 @@ enum tp_pid_state_type {
 	TP_ENABLED,
 };
 
+/*
+ * In aggregate mode the counter deltas of each switched-out task are added
+ * to a per-cpu table keyed by uid instead of being traced. Each table is
+ * only written by its own cpu from the sched_switch hook, so no locking is
+ * needed there; readers sum all the tables and tolerate a stale snapshot.
+ */
+#define TRACECTR_UID_BITS	7
+#define TRACECTR_UID_ENTRIES	(1 << TRACECTR_UID_BITS)
+
+struct tracectr_uid_entry {
+	bool valid;
+	uid_t uid;
+	u64 switches;
+	u64 cnts[NUM_EVENTS];
+};
+
+struct tracectr_uid_table {
+	bool reset;
+	struct tracectr_uid_entry entries[TRACECTR_UID_ENTRIES];
+	/* Uids that did not fit in entries[] */
+	struct tracectr_uid_entry other;
+};
+
+static struct tracectr_uid_table __percpu *uid_tables;
+
 static int tracectr_cpu_hotplug_coming_up(unsigned int cpu)
 {
 	per_cpu(hotplug_flag, cpu) = 1;
@@ -78,6 +109,62 @@ static void setup_prev_cnts(u32 cpu)
 	}
 }
 
+static struct tracectr_uid_entry *
+tracectr_uid_entry(struct tracectr_uid_table *table, uid_t uid)
+{
+	struct tracectr_uid_entry *entry;
+	u32 i, slot = hash_32(uid, TRACECTR_UID_BITS);
+
+	for (i = 0; i < TRACECTR_UID_ENTRIES; i++) {
+		entry = &table->entries[(slot + i) % TRACECTR_UID_ENTRIES];
+		if (!entry->valid) {
+			entry->uid = uid;
+			smp_store_release(&entry->valid, true);
+			return entry;
+		}
+		if (entry->uid == uid)
+			return entry;
+	}
+
+	return &table->other;
+}
+
+static void tracectr_aggregate(struct task_struct *prev, u32 cpu)
+{
+	struct tracectr_uid_table *table = per_cpu_ptr(uid_tables, cpu);
+	struct tracectr_uid_entry *entry;
+	u64 count;
+	uid_t uid;
+	int i;
+
+	/*
+	 * previous_cnts only moves while something consumes the counters, so
+	 * start from the current values instead of charging everything since
+	 * then to this task.
+	 */
+	if (READ_ONCE(table->reset)) {
+		memset(table->entries, 0, sizeof(table->entries));
+		memset(&table->other, 0, sizeof(table->other));
+		setup_prev_cnts(cpu);
+		WRITE_ONCE(table->reset, false);
+		return;
+	}
+
+	rcu_read_lock();
+	uid = __kuid_val(task_uid(prev));
+	rcu_read_unlock();
+
+	entry = tracectr_uid_entry(table, uid);
+	entry->switches++;
+
+	for (i = 0; i < NUM_EVENTS; i++) {
+		if (read_perf_event_local(cpu, ev_idx[i], &count))
+			continue;
+		entry->cnts[i] += count - per_cpu(previous_cnts[i], cpu);
+		per_cpu(previous_cnts[i], cpu) = count;
+	}
+}
+
 static void tracectr_notifier(void *data, bool preempt,
 			struct task_struct *prev, struct task_struct *next,
 			unsigned int prev_state)
@@ -89,7 +176,18 @@ static void tracectr_notifier(void *data, bool preempt,
 	if (tp_pid_state != TP_ENABLED)
 		return;
 	current_pid = next->pid;
-	if (per_cpu(old_pid, cpu) != -1) {
+	if (per_cpu(old_pid, cpu) != -1 && READ_ONCE(tp_aggregate)) {
+		/*
+		 * The counters are read back to back, so there is no need to
+		 * stop them for a consistent snapshot as the tracepoint does.
+		 */
+		if (per_cpu(hotplug_flag, cpu) == 1) {
+			per_cpu(hotplug_flag, cpu) = 0;
+			setup_prev_cnts(cpu);
+		} else {
+			tracectr_aggregate(prev, cpu);
+		}
+	} else if (per_cpu(old_pid, cpu) != -1) {
 		cnten_val = read_sysreg(pmcntenset_el0);
 		per_cpu(cntenset_val, cpu) = cnten_val;
 		/* Disable all the counters that were enabled */
@@ -177,12 +275,117 @@ static struct kobj_attribute enable_attr = __ATTR(enable,
                 sysfs_enable_show,
                 sysfs_enable_store);
 
+static ssize_t sysfs_aggregate_show(struct kobject *kobj,
+		struct kobj_attribute *attr,
+		char *buf)
+{
+	return sysfs_emit(buf, "%c\n", tp_aggregate ? '1' : '0');
+}
+
+/* Writing 1 also clears the previously aggregated counts */
+static ssize_t sysfs_aggregate_store(struct kobject *kobj,
+		struct kobj_attribute *attr,
+		const char *buf,
+		size_t count)
+{
+	bool aggregate;
+	int cpu;
+
+	if (kstrtobool(buf, &aggregate))
+		return -EINVAL;
+
+	mutex_lock(&perf_trace_lock);
+
+	if (aggregate) {
+		for_each_possible_cpu(cpu)
+			WRITE_ONCE(per_cpu_ptr(uid_tables, cpu)->reset, true);
+	}
+	WRITE_ONCE(tp_aggregate, aggregate);
+
+	mutex_unlock(&perf_trace_lock);
+
+	return count;
+}
+
+static struct kobj_attribute aggregate_attr = __ATTR(aggregate,
+		0644,
+		sysfs_aggregate_show,
+		sysfs_aggregate_store);
+
+static void tracectr_uid_merge(struct tracectr_uid_table *sum,
+		const struct tracectr_uid_entry *entry)
+{
+	struct tracectr_uid_entry *dst = tracectr_uid_entry(sum, entry->uid);
+	int i;
+
+	dst->switches += READ_ONCE(entry->switches);
+	for (i = 0; i < NUM_EVENTS; i++)
+		dst->cnts[i] += READ_ONCE(entry->cnts[i]);
+}
+
+static void tracectr_uid_show_entry(struct seq_file *m,
+		const struct tracectr_uid_entry *entry, bool other)
+{
+	if (other)
+		seq_puts(m, "other");
+	else
+		seq_put_decimal_ull(m, "", entry->uid);
+	seq_put_decimal_ull(m, " ", entry->switches);
+	seq_put_decimal_ull(m, " ", entry->cnts[0]);
+	seq_put_decimal_ull(m, " ", entry->cnts[1]);
+	seq_put_decimal_ull(m, " ", entry->cnts[2]);
+	seq_put_decimal_ull(m, " ", entry->cnts[3]);
+	seq_putc(m, '\n');
+}
+
+static int tracectr_uid_proc_show(struct seq_file *m, void *v)
+{
+	struct tracectr_uid_table *table, *sum;
+	int cpu, i;
+
+	sum = kzalloc(sizeof(*sum), GFP_KERNEL);
+	if (!sum)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		table = per_cpu_ptr(uid_tables, cpu);
+		if (READ_ONCE(table->reset))
+			continue;
+
+		for (i = 0; i < TRACECTR_UID_ENTRIES; i++) {
+			if (smp_load_acquire(&table->entries[i].valid))
+				tracectr_uid_merge(sum, &table->entries[i]);
+		}
+		sum->other.switches += READ_ONCE(table->other.switches);
+		for (i = 0; i < NUM_EVENTS; i++)
+			sum->other.cnts[i] += READ_ONCE(table->other.cnts[i]);
+	}
+
+	seq_puts(m, "# uid switches inst cyc stallbm l3dm\n");
+	for (i = 0; i < TRACECTR_UID_ENTRIES; i++) {
+		if (sum->entries[i].valid)
+			tracectr_uid_show_entry(m, &sum->entries[i], false);
+	}
+	if (sum->other.switches)
+		tracectr_uid_show_entry(m, &sum->other, true);
+
+	kfree(sum);
+
+	return 0;
+}
+
+static struct proc_dir_entry *uid_proc;
+
 static enum cpuhp_state hp_state;
 
 static int __init init_tracecounters(void)
 {
 	int rc;
 
+	uid_tables = alloc_percpu(struct tracectr_uid_table);
+	if (!uid_tables)
+		return -ENOMEM;
+
 	rc = cpuhp_setup_state_nocalls(CPUHP_AP_ONLINE_DYN,
 		"tracectr_cpu_hotplug",
 		tracectr_cpu_hotplug_coming_up,
@@ -190,6 +393,7 @@ static int __init init_tracecounters(void)
 
 	if (rc < 0) {
 		pr_err("%s: failed, error: %d\n", __func__, rc);
+		free_percpu(uid_tables);
 		return rc;
 	}
 
@@ -198,25 +402,41 @@ static int __init init_tracecounters(void)
 	perf_trace_ctrs_kobj = kobject_create_and_add("perf_debug_tp", kernel_kobj);
 	if (!perf_trace_ctrs_kobj) {
 		pr_err("cannot create kobj for perf_debug_tp!\n");
+		free_percpu(uid_tables);
 		return -ENOMEM;
 	}
-	if (sysfs_create_file(perf_trace_ctrs_kobj, &enable_attr.attr)) {
+	if (sysfs_create_file(perf_trace_ctrs_kobj, &enable_attr.attr) ||
+	    sysfs_create_file(perf_trace_ctrs_kobj, &aggregate_attr.attr)) {
 		pr_err("cannot create file in perf_debug_tp folder!\n");
 		kobject_put(perf_trace_ctrs_kobj);
+		free_percpu(uid_tables);
 		return -ENOMEM;
 	}
 
+	uid_proc = proc_create_single("perf_debug_tp_uid", 0400, NULL,
+				      tracectr_uid_proc_show);
+	if (!uid_proc)
+		pr_err("cannot create perf_debug_tp_uid proc node!\n");
+
 	return 0;
 }
 
 static void __exit exit_tracecounters(void)
 {
+	proc_remove(uid_proc);
 	cpuhp_remove_state_nocalls(hp_state);
 	if (perf_trace_ctrs_kobj) {
+		sysfs_remove_file(perf_trace_ctrs_kobj, &aggregate_attr.attr);
 		sysfs_remove_file(perf_trace_ctrs_kobj, &enable_attr.attr);
 	}
 	kobject_put(perf_trace_ctrs_kobj);
 	perf_trace_ctrs_kobj = NULL;
+
+	mutex_lock(&perf_trace_lock);
+	disable_tp_pid_locked();
+	mutex_unlock(&perf_trace_lock);
+	tracepoint_synchronize_unregister();
+	free_percpu(uid_tables);
 }
 
 module_init(init_tracecounters);
@@ -7,6 +7,14 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/mm.h>
+#include <linux/hashtable.h>
+#include <linux/percpu.h>
+#include <linux/sched/mm.h>
+#include <linux/slab.h>
+#include <trace/events/kmem.h>
+#include <trace/events/oom.h>
+#include <trace/events/sched.h>
+#include <trace/events/task.h>
 
 struct proc_dir_entry *vendor_mm;
 
@@ -70,8 +78,13 @@ static void gather_memory_usage(struct task_struct *p,
 	int i;
 	struct mm_struct *mm;
 	struct task_group *group = NULL;
-	struct task_struct *task = vendor_find_lock_task_mm(p);
+	struct task_struct *task;
 
+	/* A vfork child borrows its parent's mm until it execs or exits */
+	if (READ_ONCE(p->vfork_done))
+		return;
+
+	task = vendor_find_lock_task_mm(p);
 	if (!task) {
 		/*
 		 * All of p's threads have already detached their mm's. There's
@@ -105,6 +118,382 @@ cleanup:
 	task_unlock(task);
 }
 
+/*
+ * Incremental accounting: every process contributes its last sampled
+ * counters to the group of its oom_score_adj. Contributions are refreshed
+ * when an rss counter drifts by RSS_SAMPLE_PAGES from the last sample, and
+ * moved or dropped on oom_score_adj updates, exec and exit, so reading the
+ * totals does not need to walk the process list. Processes are counted the
+ * same way gather_memory_usage() counts them.
+ *
+ * Each entry pins its mm with mmgrab(), so the mm_struct cannot be freed
+ * and its address reused by another mm while the entry exists, e.g. between
+ * exec dropping the old mm and sched_process_exec re-tracking the process.
+ */
+#define RSS_SAMPLE_PAGES	16
+#define MM_ACCT_HASH_BITS	10
+
+struct mm_acct {
+	struct hlist_node mm_node;	/* keyed by mm, RCU */
+	struct hlist_node pid_node;	/* keyed by tgid pid, mm_acct_lock */
+	struct mm_struct *mm;		/* pinned */
+	struct pid *pid;
+	int group;
+	/* Another process (CLONE_VM without CLONE_VFORK) accounts mm too */
+	bool shared;
+	long rss[NR_MM_COUNTERS];
+	unsigned long pgtable_bytes;
+	struct rcu_head rcu;
+};
+
+static struct task_group acct_groups[NUM_OOM_ADJ_GROUPS];
+static DEFINE_HASHTABLE(mm_acct_by_mm, MM_ACCT_HASH_BITS);
+static DEFINE_HASHTABLE(mm_acct_by_pid, MM_ACCT_HASH_BITS);
+static DEFINE_SPINLOCK(mm_acct_lock);
+static struct kmem_cache *mm_acct_cache;
+static bool mm_acct_ready;
+
+/*
+ * rss_stat fires in bursts for the same mm, mostly current->mm, so remember
+ * the last entry hit on each cpu instead of hashing on every update. An
+ * entry is cleared from every cpu before it is freed.
+ */
+static DEFINE_PER_CPU(struct mm_acct *, mm_acct_last);
+
+static int oom_adj_to_group(int oom_adj)
+{
+	int i;
+
+	for (i = 0; i < NUM_OOM_ADJ_GROUPS; i++) {
+		if (group_oom_adj[i] <= oom_adj)
+			return i;
+	}
+
+	return NUM_OOM_ADJ_GROUPS - 1;
+}
+
+static void mm_acct_free(struct rcu_head *rcu)
+{
+	struct mm_acct *acct = container_of(rcu, struct mm_acct, rcu);
+
+	mmdrop(acct->mm);
+	put_pid(acct->pid);
+	kmem_cache_free(mm_acct_cache, acct);
+}
+
+/* Hold mm_acct_lock */
+static void mm_acct_charge(struct mm_acct *acct, bool charge)
+{
+	struct task_group *group = &acct_groups[acct->group];
+	int i;
+
+	for (i = 0; i < NR_MM_COUNTERS; i++) {
+		if (charge)
+			group->rss[i] += acct->rss[i];
+		else
+			group->rss[i] -= acct->rss[i];
+	}
+
+	if (charge) {
+		group->pgtable_bytes += acct->pgtable_bytes;
+		group->nr_task++;
+	} else {
+		group->pgtable_bytes -= acct->pgtable_bytes;
+		group->nr_task--;
+	}
+}
+
+/* Hold mm_acct_lock */
+static struct mm_acct *mm_acct_lookup_pid(struct pid *pid)
+{
+	struct mm_acct *acct;
+
+	hash_for_each_possible(mm_acct_by_pid, acct, pid_node,
+			       (unsigned long)pid) {
+		if (acct->pid == pid)
+			return acct;
+	}
+
+	return NULL;
+}
+
+static struct mm_acct *mm_acct_lookup_mm(struct mm_struct *mm)
+{
+	struct mm_acct *acct;
+
+	hash_for_each_possible_rcu(mm_acct_by_mm, acct, mm_node,
+				   (unsigned long)mm) {
+		if (acct->mm == mm)
+			return acct;
+	}
+
+	return NULL;
+}
+
+/* Hold mm_acct_lock */
+static void __mm_acct_remove(struct mm_acct *acct)
+{
+	int cpu;
+
+	mm_acct_charge(acct, false);
+	hash_del(&acct->pid_node);
+	hash_del_rcu(&acct->mm_node);
+
+	/* Pairs with mm_acct_cache_set() */
+	smp_mb();
+	for_each_possible_cpu(cpu)
+		cmpxchg(per_cpu_ptr(&mm_acct_last, cpu), acct, NULL);
+
+	call_rcu(&acct->rcu, mm_acct_free);
+}
+
+/* Called under rcu_read_lock() with @acct found in mm_acct_by_mm */
+static void mm_acct_cache_set(struct mm_acct *acct)
+{
+	preempt_disable();
+	this_cpu_write(mm_acct_last, acct);
+	/* Pairs with __mm_acct_remove(): never leave a removed entry cached */
+	smp_mb();
+	if (hlist_unhashed(&acct->pid_node))
+		this_cpu_cmpxchg(mm_acct_last, acct, NULL);
+	preempt_enable();
+}
+
+/* Start (or restart, after exec) accounting the process @p */
+static void mm_acct_track(struct task_struct *p)
+{
+	struct task_struct *task;
+	struct mm_acct *acct, *old, *sibling;
+	struct pid *pid = task_tgid(p);
+	unsigned long flags;
+	int i;
+
+	/* A vfork child borrows its parent's mm; gather_memory_usage() agrees */
+	if (p->flags & PF_KTHREAD || READ_ONCE(p->vfork_done))
+		return;
+
+	acct = kmem_cache_zalloc(mm_acct_cache, GFP_ATOMIC | __GFP_NOWARN);
+	if (!acct)
+		return;
+
+	task = vendor_find_lock_task_mm(p);
+	if (!task) {
+		kmem_cache_free(mm_acct_cache, acct);
+		return;
+	}
+
+	acct->mm = task->mm;
+	mmgrab(acct->mm);
+	acct->pid = get_pid(pid);
+	acct->group = oom_adj_to_group(task->signal->oom_score_adj);
+	for (i = 0; i < NR_MM_COUNTERS; i++)
+		acct->rss[i] = get_mm_counter(task->mm, i);
+	acct->pgtable_bytes = mm_pgtables_bytes(task->mm);
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	old = mm_acct_lookup_pid(pid);
+	if (old)
+		__mm_acct_remove(old);
+
+	/* mm_acct_process_exit() may already have run for a dying process */
+	if (!atomic_read(&p->signal->live)) {
+		spin_unlock_irqrestore(&mm_acct_lock, flags);
+		task_unlock(task);
+		mmdrop(acct->mm);
+		put_pid(acct->pid);
+		kmem_cache_free(mm_acct_cache, acct);
+		return;
+	}
+
+	sibling = mm_acct_lookup_mm(acct->mm);
+	if (sibling) {
+		WRITE_ONCE(sibling->shared, true);
+		acct->shared = true;
+	}
+
+	mm_acct_charge(acct, true);
+	hash_add(mm_acct_by_pid, &acct->pid_node, (unsigned long)pid);
+	hash_add_rcu(mm_acct_by_mm, &acct->mm_node, (unsigned long)acct->mm);
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+	task_unlock(task);
+}
+
+static void mm_acct_task_newtask(void *data, struct task_struct *p,
+				 unsigned long clone_flags)
+{
+	/* vfork_done is not set yet, so tell vfork children by the flag */
+	if (!(clone_flags & (CLONE_THREAD | CLONE_VFORK)))
+		mm_acct_track(p);
+}
+
+static void mm_acct_process_exec(void *data, struct task_struct *p,
+				 pid_t old_pid, struct linux_binprm *bprm)
+{
+	/* exec replaced the mm */
+	mm_acct_track(p);
+}
+
+static void mm_acct_oom_score_adj_update(void *data, struct task_struct *p)
+{
+	struct mm_acct *acct;
+	unsigned long flags;
+	int group = oom_adj_to_group(READ_ONCE(p->signal->oom_score_adj));
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	acct = mm_acct_lookup_pid(task_tgid(p));
+	if (acct && acct->group != group) {
+		mm_acct_charge(acct, false);
+		acct->group = group;
+		mm_acct_charge(acct, true);
+	}
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+}
+
+static void mm_acct_process_exit(void *data, struct task_struct *p)
+{
+	struct mm_acct *acct;
+	unsigned long flags;
+
+	/* Only once the whole thread group is gone */
+	if (atomic_read(&p->signal->live))
+		return;
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	acct = mm_acct_lookup_pid(task_tgid(p));
+	if (acct)
+		__mm_acct_remove(acct);
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+}
+
+/* Hold mm_acct_lock */
+static void mm_acct_sample(struct mm_acct *acct, int member, long count,
+			   unsigned long pgtable_bytes)
+{
+	struct task_group *group = &acct_groups[acct->group];
+
+	group->rss[member] += count - acct->rss[member];
+	acct->rss[member] = count;
+	group->pgtable_bytes += pgtable_bytes - acct->pgtable_bytes;
+	acct->pgtable_bytes = pgtable_bytes;
+}
+
+static void mm_acct_rss_stat(void *data, struct mm_struct *mm, int member,
+			     long count)
+{
+	struct mm_acct *acct;
+	unsigned long flags;
+
+	rcu_read_lock();
+	acct = this_cpu_read(mm_acct_last);
+	if (!acct || acct->mm != mm) {
+		acct = mm_acct_lookup_mm(mm);
+		if (!acct)
+			goto out;
+		mm_acct_cache_set(acct);
+	}
+
+	if (abs(count - READ_ONCE(acct->rss[member])) < RSS_SAMPLE_PAGES)
+		goto out;
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	if (!READ_ONCE(acct->shared)) {
+		/* Skip if the entry was dropped under us */
+		if (!hlist_unhashed(&acct->pid_node))
+			mm_acct_sample(acct, member, count,
+				       mm_pgtables_bytes(mm));
+	} else {
+		/* Every process sharing the mm accounts it */
+		hash_for_each_possible(mm_acct_by_mm, acct, mm_node,
+				       (unsigned long)mm) {
+			if (acct->mm == mm)
+				mm_acct_sample(acct, member, count,
+					       mm_pgtables_bytes(mm));
+		}
+	}
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+out:
+	rcu_read_unlock();
+}
+
+/* Drop every entry once no hook can run anymore */
+static void mm_acct_flush(void)
+{
+	struct mm_acct *acct;
+	struct hlist_node *tmp;
+	unsigned long flags;
+	int bkt;
+
+	tracepoint_synchronize_unregister();
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	hash_for_each_safe(mm_acct_by_pid, bkt, tmp, acct, pid_node)
+		__mm_acct_remove(acct);
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+
+	rcu_barrier();
+}
+
+static int mm_acct_init(void)
+{
+	struct task_struct *p;
+	int ret;
+
+	init_task_groups(acct_groups, NUM_OOM_ADJ_GROUPS);
+
+	mm_acct_cache = KMEM_CACHE(mm_acct, 0);
+	if (!mm_acct_cache)
+		return -ENOMEM;
+
+	ret = register_trace_task_newtask(mm_acct_task_newtask, NULL);
+	if (ret)
+		goto err_newtask;
+
+	ret = register_trace_sched_process_exec(mm_acct_process_exec, NULL);
+	if (ret)
+		goto err_exec;
+
+	ret = register_trace_oom_score_adj_update(mm_acct_oom_score_adj_update,
+						  NULL);
+	if (ret)
+		goto err_adj_update;
+
+	ret = register_trace_sched_process_exit(mm_acct_process_exit, NULL);
+	if (ret)
+		goto err_exit;
+
+	ret = register_trace_rss_stat(mm_acct_rss_stat, NULL);
+	if (ret)
+		goto err_rss_stat;
+
+	/* Pick up the processes which were alive before the hooks */
+	rcu_read_lock();
+	for_each_process(p)
+		mm_acct_track(p);
+	rcu_read_unlock();
+
+	mm_acct_ready = true;
+
+	return 0;
+
+err_rss_stat:
+	unregister_trace_sched_process_exit(mm_acct_process_exit, NULL);
+err_exit:
+	unregister_trace_oom_score_adj_update(mm_acct_oom_score_adj_update,
+					      NULL);
+err_adj_update:
+	unregister_trace_sched_process_exec(mm_acct_process_exec, NULL);
+err_exec:
+	unregister_trace_task_newtask(mm_acct_task_newtask, NULL);
+err_newtask:
+	/* The hooks which did register may have tracked processes already */
+	mm_acct_flush();
+	kmem_cache_destroy(mm_acct_cache);
+	mm_acct_cache = NULL;
+	init_task_groups(acct_groups, NUM_OOM_ADJ_GROUPS);
+
+	return ret;
+}
+
 /* show value with "kB" without space or line feed */
 static void show_pure_val_kb(struct seq_file *m, const char *s,
 			     unsigned long num, unsigned int width)
@@ -135,20 +524,11 @@ static void seq_put_range(struct seq_file *m, int start, int end, int width) {
 		seq_putc(m, ' ');
 }
 
-static int memory_usage_by_oom_score_proc_show(struct seq_file *m, void *v)
+static void show_task_groups(struct seq_file *m, struct task_group *groups)
 {
-	struct task_struct *p;
-	struct task_group groups[NUM_OOM_ADJ_GROUPS];
 	int i;
 	int prev_group_base = MAX_OOM_ADJ + 1;
 
-	init_task_groups(groups, NUM_OOM_ADJ_GROUPS);
-
-	rcu_read_lock();
-	for_each_process(p)
-		gather_memory_usage(p, groups, NUM_OOM_ADJ_GROUPS);
-	rcu_read_unlock();
-
 	/* header */
 	seq_puts(m, "# oom_group  <nr_task > <file_rss_kb> <anon_rss_kb> "
 		 "<pgtable_kb> <swap_ents_kb> <shmem_rss_kb>\n");
@@ -168,6 +548,46 @@ static int memory_usage_by_oom_score_proc_show(struct seq_file *m, void *v)
 		show_pure_val_kb(m, " ", groups[i].rss[MM_SHMEMPAGES], 14);
 		seq_putc(m, '\n');
 	}
+}
+
+static int memory_usage_by_oom_score_full_proc_show(struct seq_file *m,
+						    void *v);
+
+static int memory_usage_by_oom_score_proc_show(struct seq_file *m, void *v)
+{
+	struct task_group groups[NUM_OOM_ADJ_GROUPS];
+	unsigned long flags;
+
+	if (!mm_acct_ready)
+		return memory_usage_by_oom_score_full_proc_show(m, v);
+
+	spin_lock_irqsave(&mm_acct_lock, flags);
+	memcpy(groups, acct_groups, sizeof(groups));
+	spin_unlock_irqrestore(&mm_acct_lock, flags);
+
+	show_task_groups(m, groups);
+
+	return 0;
+}
+
+/*
+ * Debug: same report built by walking every process, to verify the
+ * incremental accounting against.
+ */
+static int memory_usage_by_oom_score_full_proc_show(struct seq_file *m,
+						    void *v)
+{
+	struct task_struct *p;
+	struct task_group groups[NUM_OOM_ADJ_GROUPS];
+
+	init_task_groups(groups, NUM_OOM_ADJ_GROUPS);
+
+	rcu_read_lock();
+	for_each_process(p)
+		gather_memory_usage(p, groups, NUM_OOM_ADJ_GROUPS);
+	rcu_read_unlock();
+
+	show_task_groups(m, groups);
 
 	return 0;
 }
@@ -178,9 +598,17 @@ int create_mm_procfs_node(void)
 	if (!vendor_mm)
 		return -ENOMEM;
 
+	if (mm_acct_init())
+		pr_warn("unable to set up memory usage accounting, walking processes instead");
+
 	if (!proc_create_single("memory_usage_by_oom_score", 0, vendor_mm,
 				memory_usage_by_oom_score_proc_show))
 		pr_warn("unable to create memory_usage_by_oom_score");
 
+	if (!proc_create_single("memory_usage_by_oom_score_full", 0400,
+				vendor_mm,
+				memory_usage_by_oom_score_full_proc_show))
+		pr_warn("unable to create memory_usage_by_oom_score_full");
+
 	return 0;
 }
@@ -63,6 +63,8 @@ struct vendor_task_struct {
 	unsigned long direct_reclaim_ts;
 	struct list_head node;
 	int queued_to_list;
+	/* cpu shard of vendor_group_list the node is queued to */
+	int list_cpu;
 	bool uclamp_fork_reset;
 	bool prefer_idle;
 	bool prefer_high_cap;
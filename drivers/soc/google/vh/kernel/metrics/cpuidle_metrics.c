@@ -12,96 +12,200 @@
 #include <linux/of_device.h>
 #include <linux/cpu.h>
 #include <linux/cpuidle.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
 #include <linux/sysfs.h>
 #include <linux/kobject.h>
 #include <trace/events/power.h>
 #include <soc/google/cpuidle_metrics.h>
 
-/* Constants for histogram bins */
+/* Constants for target residency histogram bins */
 #define NUM_TARGET_BINS 8
 #define PERCENT_INCREMENT 25
 
+/*
+ * Constants for residency histogram bins. Residencies below
+ * HIST_SUB_BUCKETS us get a bin each, every power of two above is split into
+ * HIST_SUB_BUCKETS linear bins, up to 2^(HIST_MAX_EXP + 1) us.
+ */
+#define HIST_SUB_BITS 2
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_MAX_EXP 23
+#define NUM_HIST_BUCKETS (((HIST_MAX_EXP - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + \
+			  HIST_SUB_BUCKETS)
+
 /* Constants for cluster stats */
 #define NAME_LEN 32
 #define MAX_CLUSTERS 10
 
-/* struct to store histogram statistics per state per cpu or cluster*/
-struct histogram_stats {
-	/* time entered power mode */
-	ktime_t entry_time;
+/*
+ * Residency histogram per state per cpu, only written by its cpu in the idle
+ * path. Readers and reset may race with it and lose a single count.
+ */
+struct residency_hist {
+	unsigned int bins[NUM_HIST_BUCKETS];
+
+	/* entries by % of target residency -> 0%, 25%, 50%, ..., 200% and above */
+	unsigned int target_bins[NUM_TARGET_BINS + 1];
+
+	/* idles shorter than the target residency of the state */
+	unsigned int wasted;
+};
 
-	/*
-	 * histogram bins by % of target residency incremented by %increment -> 0%, 25%, 50%, 75%,
-	 * 100%, 125%, 150%
-	 */
-	unsigned int target_time_hist[NUM_TARGET_BINS + 1];
+struct cpu_idle_stats {
+	/* time entered power mode */
+	u64 entry_time;
+	int entered_state;
+	int target_residency;
+	int state_residency[CPUIDLE_STATE_MAX];
+	struct residency_hist *hist;
 };
 
-struct power_stats {
+struct cluster_stats {
 	char name[NAME_LEN];
 	int target_residency;
-	int entered_state;
-	struct histogram_stats hist_stats[CPUIDLE_STATE_MAX];
 	bool initialized;
+	struct residency_hist __percpu *hist;
 };
 
 /* variables for cpu and cluster stats */
-DEFINE_PER_CPU(struct power_stats, all_cpu_stats);
-static DEFINE_PER_CPU(spinlock_t, cpu_spinlocks);
-static struct power_stats all_cluster_stats[MAX_CLUSTERS];
-static spinlock_t cluster_spinlocks[MAX_CLUSTERS];
+static DEFINE_PER_CPU(struct cpu_idle_stats, all_cpu_stats);
+static struct cluster_stats all_cluster_stats[MAX_CLUSTERS];
+static DEFINE_MUTEX(cluster_lock);
 static int cpuidle_state_max;
 static bool histograms_enabled = false;
 
-/* method to append to the cpuidle histogram */
-static void histogram_append(struct histogram_stats *hist_stat, s64 time_us,
-			     s64 target_residency_us)
+static inline int hist_index(u64 time_us)
+{
+	int exp;
+
+	if (time_us < HIST_SUB_BUCKETS)
+		return time_us;
+
+	exp = fls64(time_us) - 1;
+	if (exp > HIST_MAX_EXP)
+		return NUM_HIST_BUCKETS - 1;
+
+	return ((exp - HIST_SUB_BITS + 1) << HIST_SUB_BITS) |
+	       ((time_us >> (exp - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1));
+}
+
+/* lower bound of the residency histogram bin in us */
+static u64 hist_bin_low(int index)
+{
+	int exp;
+
+	if (index < HIST_SUB_BUCKETS)
+		return index;
+
+	exp = (index >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+
+	return (1ULL << exp) |
+	       ((u64)(index & (HIST_SUB_BUCKETS - 1)) << (exp - HIST_SUB_BITS));
+}
+
+/* index of the % of target residency bin, the last bin is open ended */
+static inline int target_index(u64 time_us, int target_residency_us)
 {
-	int percent_index;
+	u64 steps = time_us * (100 / PERCENT_INCREMENT);
 
-	/* append to target residency histogram */
-	percent_index = time_us * 100 / target_residency_us / PERCENT_INCREMENT;
-	if (percent_index > NUM_TARGET_BINS)
-		percent_index = NUM_TARGET_BINS;
-	hist_stat->target_time_hist[percent_index] += 1;
+	if (target_residency_us <= 0 ||
+	    steps >= (u64)target_residency_us * NUM_TARGET_BINS)
+		return NUM_TARGET_BINS;
+
+	/* below NUM_TARGET_BINS * target, so a 32-bit divide is enough */
+	return (u32)steps / (u32)target_residency_us;
+}
+
+/*
+ * method to append to the cpuidle histogram, wasted entries are counted
+ * against wasted_us and the % bins against target_residency_us
+ */
+static inline void histogram_append(struct residency_hist *hist, s64 time_us,
+				    s64 wasted_us, int target_residency_us)
+{
+	unsigned int *bin;
+
+	if (time_us < 0)
+		time_us = 0;
+
+	bin = &hist->bins[hist_index(time_us)];
+	WRITE_ONCE(*bin, *bin + 1);
+	bin = &hist->target_bins[target_index(time_us, target_residency_us)];
+	WRITE_ONCE(*bin, *bin + 1);
+	if (time_us < wasted_us)
+		WRITE_ONCE(hist->wasted, hist->wasted + 1);
+}
+
+static void histogram_add(struct residency_hist *sum, const struct residency_hist *hist)
+{
+	int i;
+
+	for (i = 0; i < NUM_HIST_BUCKETS; i++)
+		sum->bins[i] += READ_ONCE(hist->bins[i]);
+	for (i = 0; i <= NUM_TARGET_BINS; i++)
+		sum->target_bins[i] += READ_ONCE(hist->target_bins[i]);
+	sum->wasted += READ_ONCE(hist->wasted);
+}
+
+static void histogram_reset(struct residency_hist *hist)
+{
+	memset(hist, 0, sizeof(*hist));
 }
 
 /* method to register all of the cpu cluster stats */
 void cpuidle_metrics_histogram_register(char *name, int cluster_id, s64 target_residency_us)
 {
+	struct cluster_stats *cluster_stat;
+
 	if (cluster_id < 0 || cluster_id >= MAX_CLUSTERS) {
 		pr_err("Invalid cluster_id %d passed for registration of histrogram stats",
 				cluster_id);
 		return;
 	}
-	spin_lock(&cluster_spinlocks[cluster_id]);
-	if (all_cluster_stats[cluster_id].initialized) {
-		spin_unlock(&cluster_spinlocks[cluster_id]);
+
+	mutex_lock(&cluster_lock);
+	cluster_stat = &all_cluster_stats[cluster_id];
+	if (cluster_stat->initialized) {
+		mutex_unlock(&cluster_lock);
+		return;
+	}
+
+	cluster_stat->hist = alloc_percpu(struct residency_hist);
+	if (!cluster_stat->hist) {
+		pr_err("failed to allocate histogram stats of cluster_id %d\n", cluster_id);
+		mutex_unlock(&cluster_lock);
 		return;
 	}
-	strlcpy(all_cluster_stats[cluster_id].name, name, NAME_LEN);
-	all_cluster_stats[cluster_id].target_residency = target_residency_us;
-	all_cluster_stats[cluster_id].initialized = true;
-	spin_unlock(&cluster_spinlocks[cluster_id]);
+	strlcpy(cluster_stat->name, name, NAME_LEN);
+	cluster_stat->target_residency = target_residency_us;
+	/* pairs with cpuidle_metrics_histogram_append() */
+	smp_store_release(&cluster_stat->initialized, true);
+	mutex_unlock(&cluster_lock);
 }
 EXPORT_SYMBOL_GPL(cpuidle_metrics_histogram_register);
 
-/* method to append to histogram from external modules */
+/*
+ * method to append to histogram from external modules, called with
+ * preemption disabled on the exiting cpu
+ */
 inline void cpuidle_metrics_histogram_append(int cluster_id, s64 time_us)
 {
+	struct cluster_stats *cluster_stat;
+
 	if (cluster_id < 0 || cluster_id >= MAX_CLUSTERS) {
 		pr_err("Invalid cluster_id passed for histogram creation\n");
 		return;
 	}
-	spin_lock(&cluster_spinlocks[cluster_id]);
-	if (!all_cluster_stats[cluster_id].initialized) {
+
+	cluster_stat = &all_cluster_stats[cluster_id];
+	if (!smp_load_acquire(&cluster_stat->initialized)) {
 		pr_err("cluster_id %d not initialized for histogram creation", cluster_id);
-		spin_unlock(&cluster_spinlocks[cluster_id]);
 		return;
 	}
-	histogram_append(&all_cluster_stats[cluster_id].hist_stats[0], time_us,
-			 all_cluster_stats[cluster_id].target_residency);
-	spin_unlock(&cluster_spinlocks[cluster_id]);
+	histogram_append(raw_cpu_ptr(cluster_stat->hist), time_us,
+			 cluster_stat->target_residency, cluster_stat->target_residency);
 }
 
 EXPORT_SYMBOL_GPL(cpuidle_metrics_histogram_append);
@@ -109,59 +213,59 @@ EXPORT_SYMBOL_GPL(cpuidle_metrics_histogram_append);
 static inline void reset_all_histograms(void)
 {
 	int idle_state, cluster, cpu = 0;
-	struct power_stats *cpu_stat;
-	struct power_stats *cluster_stat;
+	struct cpu_idle_stats *cpu_stat;
+	struct cluster_stats *cluster_stat;
 
 	/* clear all histograms per cpu per state */
-	for (idle_state = 0; idle_state <= cpuidle_state_max; idle_state++) {
-		for_each_possible_cpu (cpu) {
-			spin_lock(&per_cpu(cpu_spinlocks, cpu));
-			cpu_stat = &per_cpu(all_cpu_stats, cpu);
-			memset(cpu_stat->hist_stats[idle_state].target_time_hist, 0,
-				   sizeof(cpu_stat->hist_stats[idle_state].target_time_hist));
-			spin_unlock(&per_cpu(cpu_spinlocks, cpu));
-		}
+	for_each_possible_cpu (cpu) {
+		cpu_stat = &per_cpu(all_cpu_stats, cpu);
+		if (!cpu_stat->hist)
+			continue;
+		for (idle_state = 0; idle_state <= cpuidle_state_max; idle_state++)
+			histogram_reset(&cpu_stat->hist[idle_state]);
 	}
 
 	/* clear all histograms per cluster */
+	mutex_lock(&cluster_lock);
 	for (cluster = 0; cluster < MAX_CLUSTERS; cluster++) {
-		spin_lock(&cluster_spinlocks[cluster]);
-		if (all_cluster_stats[cluster].initialized) {
-			cluster_stat = &all_cluster_stats[cluster];
-			memset(cluster_stat->hist_stats[0].target_time_hist, 0,
-				   sizeof(cluster_stat->hist_stats[0].target_time_hist));
-		}
-		spin_unlock(&cluster_spinlocks[cluster]);
+		cluster_stat = &all_cluster_stats[cluster];
+		if (!cluster_stat->initialized)
+			continue;
+		for_each_possible_cpu (cpu)
+			histogram_reset(per_cpu_ptr(cluster_stat->hist, cpu));
 	}
+	mutex_unlock(&cluster_lock);
 }
 
 static void cpu_idle_hook(void *data, unsigned int state, unsigned int cpu)
 {
-	struct power_stats *cpu_stat;
-	spin_lock(&per_cpu(cpu_spinlocks, cpu));
-	cpu_stat = &per_cpu(all_cpu_stats, cpu);
+	struct cpu_idle_stats *cpu_stat = &per_cpu(all_cpu_stats, cpu);
+	int entered_state;
 
 	if (state != PWR_EVENT_EXIT) {
 		/* log entered state and time */
 		cpu_stat->entered_state = state;
-		cpu_stat->hist_stats[cpu_stat->entered_state].entry_time = ktime_get_mono_fast_ns();
+		cpu_stat->entry_time = ktime_get_mono_fast_ns();
 	} else {
 		s64 time_delta;
-		struct histogram_stats hist_stat = cpu_stat->hist_stats[cpu_stat->entered_state];
+
+		entered_state = cpu_stat->entered_state;
+		if (entered_state < 0 || entered_state > cpuidle_state_max)
+			return;
 
 		/* find time delta and append to histogram */
-		time_delta = ktime_to_us(ktime_sub(ktime_get_mono_fast_ns(), hist_stat.entry_time));
-		histogram_append(&cpu_stat->hist_stats[cpu_stat->entered_state], time_delta,
+		time_delta = ktime_to_us(ktime_sub(ktime_get_mono_fast_ns(),
+						   cpu_stat->entry_time));
+		histogram_append(&cpu_stat->hist[entered_state], time_delta,
+				 cpu_stat->state_residency[entered_state],
 				 cpu_stat->target_residency);
 	}
-
-	spin_unlock(&per_cpu(cpu_spinlocks, cpu));
 }
 
 static ssize_t cpuidle_histogram_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
 {
 	int idle_state, bin_num, cpu, ret = 0;
-	struct power_stats cpu_stat;
+	struct cpu_idle_stats *cpu_stat;
 
 	ret = sysfs_emit(buf,
 		"\n0%% %d%% %d%% \n\n",
@@ -171,20 +275,17 @@ static ssize_t cpuidle_histogram_show(struct kobject *kobj, struct kobj_attribut
 		// emit state
 		ret += sysfs_emit_at(buf, ret, "%d\n", idle_state);
 		for_each_possible_cpu (cpu) {
-			spin_lock(&per_cpu(cpu_spinlocks, cpu));
-			cpu_stat = per_cpu(all_cpu_stats, cpu);
+			cpu_stat = &per_cpu(all_cpu_stats, cpu);
 			// emit cpu and target residency in us
 			ret += sysfs_emit_at(buf, ret,
 					"%d %d\n", cpu,
-					cpu_stat.target_residency);
+					cpu_stat->target_residency);
 
 			/* output histogram */
-			for (bin_num = 0; bin_num <= NUM_TARGET_BINS; bin_num++) {
-				ret += sysfs_emit_at(buf, ret, "%d ",
-						cpu_stat.hist_stats[idle_state].target_time_hist[bin_num]);
-			}
+			for (bin_num = 0; bin_num <= NUM_TARGET_BINS; bin_num++)
+				ret += sysfs_emit_at(buf, ret, "%u ",
+					READ_ONCE(cpu_stat->hist[idle_state].target_bins[bin_num]));
 			ret += sysfs_emit_at(buf, ret, "\n");
-			spin_unlock(&per_cpu(cpu_spinlocks, cpu));
 		}
 		ret += sysfs_emit_at(buf, ret, "\n");
 	}
@@ -195,31 +296,117 @@ static ssize_t cpuidle_histogram_show(struct kobject *kobj, struct kobj_attribut
 static ssize_t cpucluster_histogram_show(struct kobject *kobj, struct kobj_attribute *attr,
 					 char *buf)
 {
-	int cluster, bin_num, ret = 0;
-	struct power_stats cluster_stat;
+	int cluster, bin_num, cpu, ret = 0;
+	struct cluster_stats *cluster_stat;
+	struct residency_hist *sum;
+
+	sum = kmalloc(sizeof(*sum), GFP_KERNEL);
+	if (!sum)
+		return -ENOMEM;
 
 	ret = sysfs_emit(buf,
 		"\n0%% %d%% %d %%\n\n",
 		NUM_TARGET_BINS * PERCENT_INCREMENT, PERCENT_INCREMENT);
 
+	mutex_lock(&cluster_lock);
 	for (cluster = 0; cluster < MAX_CLUSTERS; cluster++) {
-		spin_lock(&cluster_spinlocks[cluster]);
-		if (all_cluster_stats[cluster].initialized) {
-			cluster_stat = all_cluster_stats[cluster];
-			// output cluster name and target residency
-			ret += sysfs_emit_at(buf, ret,
-					"%-7s %d\n", cluster_stat.name,
-					cluster_stat.target_residency);
+		cluster_stat = &all_cluster_stats[cluster];
+		if (!cluster_stat->initialized)
+			continue;
+
+		/* aggregate the cluster histogram of every cpu */
+		histogram_reset(sum);
+		for_each_possible_cpu (cpu)
+			histogram_add(sum, per_cpu_ptr(cluster_stat->hist, cpu));
+
+		// output cluster name and target residency
+		ret += sysfs_emit_at(buf, ret,
+				"%-7s %d\n", cluster_stat->name,
+				cluster_stat->target_residency);
+
+		/* output histogram */
+		for (bin_num = 0; bin_num <= NUM_TARGET_BINS; bin_num++)
+			ret += sysfs_emit_at(buf, ret, "%u ", sum->target_bins[bin_num]);
+		ret += sysfs_emit_at(buf, ret, "\n");
+	}
+	mutex_unlock(&cluster_lock);
 
-			/* output histogram */
-			for (bin_num = 0; bin_num <= NUM_TARGET_BINS; bin_num++) {
-				ret += sysfs_emit_at(
-					buf, ret, "%d ",
-					cluster_stat.hist_stats[0].target_time_hist[bin_num]);
-			}
-			ret += sysfs_emit_at(buf, ret, "\n");
+	kfree(sum);
+	return ret;
+}
+
+static ssize_t residency_histogram_emit(char *buf, int ret, const struct residency_hist *hist)
+{
+	int i;
+
+	for (i = 0; i < NUM_HIST_BUCKETS; i++) {
+		/* leave room for the rest of the line */
+		if (ret >= PAGE_SIZE - 32)
+			break;
+		if (hist->bins[i])
+			ret += sysfs_emit_at(buf, ret, "%llu:%u ", hist_bin_low(i), hist->bins[i]);
+	}
+	ret += sysfs_emit_at(buf, ret, "\n");
+
+	return ret;
+}
+
+static ssize_t cpuidle_residency_show(struct kobject *kobj, struct kobj_attribute *attr,
+				      char *buf)
+{
+	int idle_state, cluster, cpu, ret = 0;
+	struct cluster_stats *cluster_stat;
+	struct residency_hist *sum;
+
+	sum = kmalloc(sizeof(*sum), GFP_KERNEL);
+	if (!sum)
+		return -ENOMEM;
+
+	/* bins are "lower bound in us:count", then wasted entries */
+	for (idle_state = 0; idle_state <= cpuidle_state_max; idle_state++) {
+		histogram_reset(sum);
+		for_each_possible_cpu (cpu)
+			histogram_add(sum, &per_cpu(all_cpu_stats, cpu).hist[idle_state]);
+
+		ret += sysfs_emit_at(buf, ret, "state%d wasted %u\n", idle_state, sum->wasted);
+		ret = residency_histogram_emit(buf, ret, sum);
+	}
+
+	mutex_lock(&cluster_lock);
+	for (cluster = 0; cluster < MAX_CLUSTERS; cluster++) {
+		cluster_stat = &all_cluster_stats[cluster];
+		if (!cluster_stat->initialized)
+			continue;
+
+		histogram_reset(sum);
+		for_each_possible_cpu (cpu)
+			histogram_add(sum, per_cpu_ptr(cluster_stat->hist, cpu));
+
+		ret += sysfs_emit_at(buf, ret, "%s wasted %u\n", cluster_stat->name, sum->wasted);
+		ret = residency_histogram_emit(buf, ret, sum);
+	}
+	mutex_unlock(&cluster_lock);
+
+	kfree(sum);
+	return ret;
+}
+
+static ssize_t cpuidle_wasted_show(struct kobject *kobj, struct kobj_attribute *attr, char *buf)
+{
+	int idle_state, cpu, ret = 0;
+	struct cpu_idle_stats *cpu_stat;
+
+	for (idle_state = 0; idle_state <= cpuidle_state_max; idle_state++) {
+		// emit state
+		ret += sysfs_emit_at(buf, ret, "%d\n", idle_state);
+		for_each_possible_cpu (cpu) {
+			cpu_stat = &per_cpu(all_cpu_stats, cpu);
+			// emit cpu, target residency in us and wasted entries
+			ret += sysfs_emit_at(buf, ret, "%d %d %u\n", cpu,
+					cpu_stat->state_residency[idle_state],
+					READ_ONCE(cpu_stat->hist[idle_state].wasted));
 		}
-		spin_unlock(&cluster_spinlocks[cluster]);
+		ret += sysfs_emit_at(buf, ret, "\n");
 	}
 
 	return ret;
@@ -266,6 +453,10 @@ static struct kobj_attribute cpuidle_histogram_attr =
 	__ATTR(cpuidle_histogram, 0444, cpuidle_histogram_show, NULL);
 static struct kobj_attribute cpucluster_histogram_attr =
 	__ATTR(cpucluster_histogram, 0444, cpucluster_histogram_show, NULL);
+static struct kobj_attribute cpuidle_residency_attr =
+	__ATTR(residency, 0444, cpuidle_residency_show, NULL);
+static struct kobj_attribute cpuidle_wasted_attr =
+	__ATTR(wasted, 0444, cpuidle_wasted_show, NULL);
 static struct kobj_attribute cpuidle_histogram_enable_attr =
 	__ATTR(enable, 0664, cpuidle_histogram_enable_show, cpuidle_histogram_enable_store);
 static struct kobj_attribute cpuidle_histogram_reset_attr =
@@ -275,6 +466,8 @@ static struct kobj_attribute cpuidle_histogram_reset_attr =
 static struct attribute *cpuidle_histogram_attrs[] = {
 	&cpuidle_histogram_attr.attr,
 	&cpucluster_histogram_attr.attr,
+	&cpuidle_residency_attr.attr,
+	&cpuidle_wasted_attr.attr,
 	&cpuidle_histogram_enable_attr.attr,
 	&cpuidle_histogram_reset_attr.attr,
 	NULL };
@@ -287,42 +480,67 @@ static const struct attribute_group cpuidle_histogram_attr_group = {
 int cpuidle_metrics_init(struct kobject *metrics_kobj)
 {
 	int ret = 0;
-	int cpu, target_residency, max, cluster_index;
+	int cpu, state, target_residency, max;
 
 	if (!metrics_kobj) {
 		pr_err("metrics_kobj is not initialized\n");
 		return -EINVAL;
 	}
-	ret = sysfs_create_group(metrics_kobj, &cpuidle_histogram_attr_group);
-	if (ret) {
-		pr_err("failed to create cpuidle_histogram folder\n");
-		return ret;
-	}
 
 	for_each_possible_cpu (cpu) {
 		struct device_node *cpu_node, *state_node;
-		struct power_stats *stats = &per_cpu(all_cpu_stats, cpu);
-		spin_lock_init(&per_cpu(cpu_spinlocks, cpu));
+		struct cpu_idle_stats *stats = &per_cpu(all_cpu_stats, cpu);
 
 		/* find min residency per cpu */
 		cpu_node = of_cpu_device_node_get(cpu);
 		state_node = of_parse_phandle(cpu_node, "cpu-idle-states", 0);
 		ret = of_property_read_u32(state_node, "min-residency-us", &target_residency);
+		of_node_put(state_node);
 		stats->target_residency = target_residency;
 
 		/* find maximum idle state */
 		max = of_count_phandle_with_args(cpu_node, "cpu-idle-states", NULL);
 		if (max > cpuidle_state_max)
-			cpuidle_state_max = max;
+			cpuidle_state_max = min(max, CPUIDLE_STATE_MAX - 1);
+
+		/* state 0 is WFI, the others follow cpu-idle-states */
+		stats->state_residency[0] = 1;
+		for (state = 1; state < CPUIDLE_STATE_MAX && state <= max; state++) {
+			state_node = of_parse_phandle(cpu_node, "cpu-idle-states", state - 1);
+			if (!of_property_read_u32(state_node, "min-residency-us",
+						  &target_residency))
+				stats->state_residency[state] = target_residency;
+			of_node_put(state_node);
+		}
+		of_node_put(cpu_node);
 	}
 
-	for (cluster_index = 0; cluster_index < MAX_CLUSTERS; cluster_index++) {
-		all_cluster_stats[cluster_index].initialized = false;
-		spin_lock_init(&cluster_spinlocks[cluster_index]);
+	for_each_possible_cpu (cpu) {
+		struct cpu_idle_stats *stats = &per_cpu(all_cpu_stats, cpu);
+
+		stats->hist = kcalloc_node(cpuidle_state_max + 1, sizeof(*stats->hist),
+					   GFP_KERNEL, cpu_to_node(cpu));
+		if (!stats->hist) {
+			ret = -ENOMEM;
+			goto err_alloc;
+		}
+	}
+
+	ret = sysfs_create_group(metrics_kobj, &cpuidle_histogram_attr_group);
+	if (ret) {
+		pr_err("failed to create cpuidle_histogram folder\n");
+		goto err_alloc;
 	}
 
 	histograms_enabled = false;
 
 	pr_debug("cpuidle_metrics driver initialized!\n");
 	return ret;
+
+err_alloc:
+	for_each_possible_cpu (cpu) {
+		kfree(per_cpu(all_cpu_stats, cpu).hist);
+		per_cpu(all_cpu_stats, cpu).hist = NULL;
+	}
+	return ret;
 }
@@ -69,10 +69,20 @@ struct rt_runnable {
 	pid_t pid;
 };
 
+/*
+ * Only the owning CPU updates its top_rt_runnable, from the sched_switch hook.
+ * Readers take a consistent copy of the heap through @seq, and a reset from
+ * sysfs bumps rt_runnable_gen which the owner applies on its next update.
+ */
 struct top_rt_runnable {
+	seqcount_t seq;
+	/* min-heap on latency, rt_runnable[0] is the smallest of the top entries */
 	struct rt_runnable rt_runnable[RT_RUNNABLE_ARR_SIZE];
-	int min_idx;
+	int nr;
+	u64 threshold;
+	unsigned long gen;
 	atomic64_t count;
+	u64 hist[RT_RUNNABLE_HIST_SIZE];
 };
 
 struct irq_entry {
@@ -85,67 +95,96 @@ static struct resume_latency resume_latency_stats;
 static struct long_irq long_irq_stat;
 
 static DEFINE_PER_CPU(struct top_rt_runnable, top_rt_runnable);
-static DEFINE_PER_CPU(spinlock_t, rt_runnable_lock);
+static atomic_long_t rt_runnable_gen;
 unsigned long long_rt_runnable_threshold_ns = 1500000UL;
 
 /*********************************************************************
  *                          HELPER FUNCTIONS                         *
  *********************************************************************/
 
-static bool is_top_latency(u64 latency)
+static void rt_runnable_sync_gen(struct top_rt_runnable *trr)
 {
-	struct top_rt_runnable trr;
-	int cpu = raw_smp_processor_id();
+	unsigned long gen = atomic_long_read(&rt_runnable_gen);
 
-	spin_lock(&per_cpu(rt_runnable_lock, cpu));
-	trr = per_cpu(top_rt_runnable, cpu);
-	spin_unlock(&per_cpu(rt_runnable_lock, cpu));
+	if (likely(trr->gen == gen))
+		return;
 
-	return latency > trr.rt_runnable[trr.min_idx].latency;
+	raw_write_seqcount_begin(&trr->seq);
+	trr->nr = 0;
+	trr->threshold = 0;
+	atomic64_set(&trr->count, 0);
+	memset(trr->hist, 0, sizeof(trr->hist));
+	trr->gen = gen;
+	raw_write_seqcount_end(&trr->seq);
 }
 
-static void update_min_latency(struct task_struct *prev, struct task_struct *next, u64 latency)
+static void rt_runnable_sift_up(struct rt_runnable *heap, int i)
 {
-	u64 min_latency = -1LL;
-	struct rt_runnable *rt_runnable;
-	struct top_rt_runnable *trr;
-	int min_idx, i, cpu;
-	bool in_arr = false;
+	while (i > 0) {
+		int parent = (i - 1) / 2;
 
-	cpu = raw_smp_processor_id();
-	spin_lock(&per_cpu(rt_runnable_lock, cpu));
-	trr = this_cpu_ptr(&top_rt_runnable);
+		if (heap[parent].latency <= heap[i].latency)
+			break;
+		swap(heap[parent], heap[i]);
+		i = parent;
+	}
+}
+
+static void rt_runnable_sift_down(struct rt_runnable *heap, int nr, int i)
+{
+	for (;;) {
+		int l = 2 * i + 1, r = l + 1, min = i;
+
+		if (l < nr && heap[l].latency < heap[min].latency)
+			min = l;
+		if (r < nr && heap[r].latency < heap[min].latency)
+			min = r;
+		if (min == i)
+			break;
+		swap(heap[min], heap[i]);
+		i = min;
+	}
+}
+
+static void update_min_latency(struct top_rt_runnable *trr, struct task_struct *prev,
+			       struct task_struct *next, u64 latency)
+{
+	struct rt_runnable *rt_runnable;
+	int i;
 
 	atomic64_inc(&(trr->count));
 
+	raw_write_seqcount_begin(&trr->seq);
+
 	/* Search if the pid is already in the top_runnable, if so, update it */
-	for (i = 0; i < RT_RUNNABLE_ARR_SIZE; i++) {
-		rt_runnable =  &trr->rt_runnable[i];
+	for (i = 0; i < trr->nr; i++) {
+		rt_runnable = &trr->rt_runnable[i];
 		if (rt_runnable->pid == next->pid) {
-			in_arr = true;
-			rt_runnable->latency = latency;
-			break;
+			if (latency > rt_runnable->latency) {
+				rt_runnable->latency = latency;
+				rt_runnable_sift_down(trr->rt_runnable, trr->nr, i);
+			}
+			goto out;
 		}
 	}
-	if (!in_arr){
-		rt_runnable = &trr->rt_runnable[trr->min_idx];
-		rt_runnable->latency = latency;
-		strlcpy(rt_runnable->comm, next->comm, TASK_COMM_LEN);
-		strlcpy(rt_runnable->prev_comm, prev->comm, TASK_COMM_LEN);
-		rt_runnable->pid = next->pid;
-	}
 
-	/* Update min entry among top_rt_runnable */
-	for (i = 0; i < RT_RUNNABLE_ARR_SIZE; i++) {
-		rt_runnable =  &trr->rt_runnable[i];
-		if (rt_runnable->latency < min_latency) {
-			min_latency = rt_runnable->latency;
-			min_idx = i;
-		}
-	}
+	/* Either append or replace the min entry */
+	i = trr->nr < RT_RUNNABLE_ARR_SIZE ? trr->nr++ : 0;
+	rt_runnable = &trr->rt_runnable[i];
+	rt_runnable->latency = latency;
+	rt_runnable->pid = next->pid;
+	/* Raw copies, termination is left to the reader */
+	memcpy(rt_runnable->comm, next->comm, TASK_COMM_LEN);
+	memcpy(rt_runnable->prev_comm, prev->comm, TASK_COMM_LEN);
+	if (i)
+		rt_runnable_sift_up(trr->rt_runnable, i);
+	else
+		rt_runnable_sift_down(trr->rt_runnable, trr->nr, 0);
 
-	trr->min_idx = min_idx;
-	spin_unlock(&per_cpu(rt_runnable_lock, cpu));
+out:
+	/* Until the heap is full every long runnable qualifies */
+	trr->threshold = trr->nr == RT_RUNNABLE_ARR_SIZE ? trr->rt_runnable[0].latency : 0;
+	raw_write_seqcount_end(&trr->seq);
 }
 
 static int irq_latency_cmp(const void *a, const void *b)
@@ -356,6 +395,7 @@ void vh_sched_switch_pixel_mod(void *data, bool preempt,
 		unsigned int prev_state)
 {
 	struct vendor_task_struct *vnext, *vprev;
+	struct top_rt_runnable *trr;
 	u64 now, runnable_delta;
 
 	now = sched_clock();
@@ -376,12 +416,17 @@ void vh_sched_switch_pixel_mod(void *data, bool preempt,
 		return;
 
 	runnable_delta = now - vnext->runnable_start_ns;
+
+	trr = this_cpu_ptr(&top_rt_runnable);
+	rt_runnable_sync_gen(trr);
+	trr->hist[min_t(int, fls64(runnable_delta >> RT_RUNNABLE_HIST_SHIFT),
+			RT_RUNNABLE_HIST_SIZE - 1)]++;
+
 	if (runnable_delta < long_rt_runnable_threshold_ns ||
-		!is_top_latency(runnable_delta))
+		runnable_delta <= trr->threshold)
 		return;
 
-	update_min_latency(prev, next, runnable_delta);
-
+	update_min_latency(trr, prev, next, runnable_delta);
 }
 
 /*******************************************************************
@@ -691,26 +736,31 @@ static ssize_t long_runnable_metrics_show(struct kobject *kobj,
 					 struct kobj_attribute *attr,
 					 char *buf)
 {
-	int cpu, i;
+	int cpu, i, nr;
+	unsigned int seq;
 	ssize_t count = 0;
-	struct top_rt_runnable trr;
-	struct rt_runnable long_rt_runnable;
+	struct top_rt_runnable *trr;
 	struct rt_runnable sorted_trr[RT_RUNNABLE_ARR_SIZE];
+	unsigned long gen = atomic_long_read(&rt_runnable_gen);
+	bool stale;
 
 	for_each_possible_cpu(cpu) {
 		count += sysfs_emit_at(buf, count, "cpu %d\n",cpu);
-		spin_lock(&per_cpu(rt_runnable_lock, cpu));
-		trr = per_cpu(top_rt_runnable, cpu);
-		spin_unlock(&per_cpu(rt_runnable_lock, cpu));
+		trr = &per_cpu(top_rt_runnable, cpu);
+		do {
+			seq = read_seqcount_begin(&trr->seq);
+			stale = trr->gen != gen;
+			nr = stale ? 0 : trr->nr;
+			memcpy(sorted_trr, trr->rt_runnable, sizeof(sorted_trr));
+		} while (read_seqcount_retry(&trr->seq, seq));
 		count += sysfs_emit_at(buf, count, "LONG RT_RUNNABLE: %lld\n",
-				atomic64_read(&(trr.count)));
+				stale ? 0 : atomic64_read(&(trr->count)));
 
-		for (i = 0; i < RT_RUNNABLE_ARR_SIZE; i++) {
-			long_rt_runnable = trr.rt_runnable[i];
-			strlcpy(sorted_trr[i].comm, long_rt_runnable.comm, TASK_COMM_LEN);
-			strlcpy(sorted_trr[i].prev_comm, long_rt_runnable.prev_comm,
-				TASK_COMM_LEN);
-			sorted_trr[i].latency = long_rt_runnable.latency;
+		memset(&sorted_trr[nr], 0, sizeof(struct rt_runnable) *
+						(RT_RUNNABLE_ARR_SIZE - nr));
+		for (i = 0; i < nr; i++) {
+			sorted_trr[i].comm[TASK_COMM_LEN - 1] = '\0';
+			sorted_trr[i].prev_comm[TASK_COMM_LEN - 1] = '\0';
 		}
 		sort(sorted_trr, RT_RUNNABLE_ARR_SIZE, sizeof(struct rt_runnable),
 						runnable_latency_cmp, NULL);
@@ -725,25 +775,42 @@ static ssize_t long_runnable_metrics_show(struct kobject *kobj,
 	return count;
 }
 
-static ssize_t runnable_stats_reset_store(struct kobject *kobj,
-					  struct kobj_attribute *attr,
-					  const char *buf,
-					  size_t count)
+static ssize_t runnable_histogram_show(struct kobject *kobj,
+				       struct kobj_attribute *attr,
+				       char *buf)
 {
-	int cpu;
+	int cpu, i;
+	ssize_t count = 0;
 	struct top_rt_runnable *trr;
+	unsigned long gen = atomic_long_read(&rt_runnable_gen);
+
+	count += sysfs_emit_at(buf, count, "lower_bound_ns:");
+	for (i = 0; i < RT_RUNNABLE_HIST_SIZE; i++)
+		count += sysfs_emit_at(buf, count, " %llu",
+				       i ? 1ULL << (i - 1 + RT_RUNNABLE_HIST_SHIFT) : 0);
+	count += sysfs_emit_at(buf, count, "\n");
 
 	for_each_possible_cpu(cpu) {
-		spin_lock(&per_cpu(rt_runnable_lock, cpu));
 		trr = &per_cpu(top_rt_runnable, cpu);
-		atomic64_set(&(trr->count), 0);
-		memset(trr->rt_runnable, 0, sizeof(struct rt_runnable) *
-							RT_RUNNABLE_ARR_SIZE);
-		spin_unlock(&per_cpu(rt_runnable_lock, cpu));
+		count += sysfs_emit_at(buf, count, "cpu %d:", cpu);
+		for (i = 0; i < RT_RUNNABLE_HIST_SIZE; i++)
+			count += sysfs_emit_at(buf, count, " %llu",
+					READ_ONCE(trr->gen) == gen ? READ_ONCE(trr->hist[i]) : 0);
+		count += sysfs_emit_at(buf, count, "\n");
 	}
 	return count;
 }
 
+static ssize_t runnable_stats_reset_store(struct kobject *kobj,
+					  struct kobj_attribute *attr,
+					  const char *buf,
+					  size_t count)
+{
+	/* Each CPU clears its own stats on its next update */
+	atomic_long_inc(&rt_runnable_gen);
+	return count;
+}
+
 static ssize_t runnable_stats_enable_store(struct kobject *kobj,
 					  struct kobj_attribute *attr,
 					  const char *buf,
@@ -811,6 +878,11 @@ static struct kobj_attribute long_runnable_metrics_attr = __ATTR(stats,
 							  long_runnable_metrics_show,
 							  NULL);
 
+static struct kobj_attribute runnable_histogram_attr = __ATTR(histogram,
+							  0444,
+							  runnable_histogram_show,
+							  NULL);
+
 static struct kobj_attribute runnable_stats_reset_attr = __ATTR(
 							stats_reset,
 							0200,
@@ -855,6 +927,7 @@ static const struct attribute_group resume_latency_attr_group = {
 
 static struct attribute *runnable_attrs[] = {
 	&long_runnable_metrics_attr.attr,
+	&runnable_histogram_attr.attr,
 	&runnable_stats_reset_attr.attr,
 	&runnable_stats_enable_attr.attr,
 	&runnable_stats_disable_attr.attr,
@@ -933,7 +1006,7 @@ int perf_metrics_init(struct kobject *metrics_kobj)
 	}
 
 	for_each_possible_cpu(cpu) {
-		spin_lock_init(&per_cpu(rt_runnable_lock, cpu));
+		seqcount_init(&per_cpu(top_rt_runnable, cpu).seq);
 	}
 	ret = register_trace_sched_wakeup(vh_sched_wakeup_pixel_mod, NULL);
 	if (ret)
@@ -22,6 +22,10 @@
 
 #define RT_RUNNABLE_ARR_SIZE 5
 
+/* log2 buckets of RT runnable latency, in units of 1024ns */
+#define RT_RUNNABLE_HIST_SHIFT 10
+#define RT_RUNNABLE_HIST_SIZE 24
+
 #define LATENCY_CNT_SMALL (RESUME_LATENCY_BOUND_SMALL / RESUME_LATENCY_STEP_SMALL)
 #define LATENCY_CNT_MID ((RESUME_LATENCY_BOUND_MID - RESUME_LATENCY_BOUND_SMALL) / \
 	RESUME_LATENCY_STEP_MID)
@@ -14,7 +14,7 @@
 #include "sched_events.h"
 #include <performance/gs_perf_mon/gs_perf_mon.h>
 
-struct vendor_group_list vendor_group_list[VG_MAX];
+struct vendor_group_list vendor_group_list[CONFIG_VH_SCHED_MAX_CPU_NR][VG_MAX];
 
 #if IS_ENABLED(CONFIG_UCLAMP_STATS)
 extern void update_uclamp_stats(int cpu, u64 time);
@@ -128,8 +128,8 @@ void vh_scheduler_tick_pixel_mod(void *data, struct rq *rq)
 	/* Check if an RT task needs to move to a better fitting CPU */
 	check_migrate_rt_task(rq, rq->curr);
 
-	/* Should be really done when capacity change */
-	update_auto_fits_capacity();
+	/* Recompute auto fits capacity when capacity_orig changed */
+	check_auto_fits_capacity(cpu_of(rq));
 
 	/*
 	 * Update our performance counters for profiling per
@@ -171,7 +171,8 @@ void rvh_enqueue_task_pixel_mod(void *data, struct rq *rq, struct task_struct *p
 	raw_spin_lock(&vp->lock);
 	if (vp->queued_to_list == LIST_NOT_QUEUED) {
 		group = get_vendor_group(p);
-		add_to_vendor_group_list(&vp->node, group);
+		vp->list_cpu = cpu_of(rq);
+		add_to_vendor_group_list(&vp->node, group, vp->list_cpu);
 		vp->queued_to_list = LIST_QUEUED;
 	}
 	raw_spin_unlock(&vp->lock);
@@ -201,7 +202,7 @@ void rvh_dequeue_task_pixel_mod(void *data, struct rq *rq, struct task_struct *p
 	raw_spin_lock(&vp->lock);
 	if (vp->queued_to_list == LIST_QUEUED) {
 		group = get_vendor_group(p);
-		remove_from_vendor_group_list(&vp->node, group);
+		remove_from_vendor_group_list(&vp->node, group, vp->list_cpu);
 		vp->queued_to_list = LIST_NOT_QUEUED;
 	}
 	raw_spin_unlock(&vp->lock);
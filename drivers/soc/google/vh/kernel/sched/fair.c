@@ -51,6 +51,12 @@ static unsigned int early_boot_boost_uclamp_min = 563;
 module_param(early_boot_boost_uclamp_min, uint, 0644);
 
 unsigned int sched_auto_fits_capacity[CONFIG_VH_SCHED_MAX_CPU_NR];
+static DEFINE_RAW_SPINLOCK(sched_auto_fits_lock);
+seqcount_raw_spinlock_t sched_auto_fits_seq =
+	SEQCNT_RAW_SPINLOCK_ZERO(sched_auto_fits_seq, &sched_auto_fits_lock);
+/* inputs sched_auto_fits_capacity was computed from */
+static unsigned long auto_fits_capacity_orig[CONFIG_VH_SCHED_MAX_CPU_NR];
+static bool auto_fits_dvfs_headroom;
 unsigned int sched_capacity_margin[CONFIG_VH_SCHED_MAX_CPU_NR] =
 	{ [0 ... CONFIG_VH_SCHED_MAX_CPU_NR - 1] = DEF_UTIL_THRESHOLD };
 unsigned int sched_dvfs_headroom[CONFIG_VH_SCHED_MAX_CPU_NR] =
@@ -63,7 +69,7 @@ unsigned int __read_mostly sched_per_task_iowait_boost_max_value = 0;
 
 struct vendor_group_property vg[VG_MAX];
 
-extern struct vendor_group_list vendor_group_list[VG_MAX];
+extern struct vendor_group_list vendor_group_list[CONFIG_VH_SCHED_MAX_CPU_NR][VG_MAX];
 
 bool wait_for_init = true;
 
@@ -606,6 +612,66 @@ static inline const cpumask_t *get_preferred_idle_mask(struct task_struct *p)
 	}
 }
 
+static bool auto_fits_capacity_changed(void)
+{
+	int cpu;
+
+	if (auto_fits_dvfs_headroom != static_branch_likely(&auto_dvfs_headroom_enable))
+		return true;
+
+	for (cpu = 0; cpu < pixel_cpu_num; cpu++) {
+		if (auto_fits_capacity_orig[cpu] != capacity_orig_of(cpu))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Recompute sched_auto_fits_capacity. It only depends on capacity_orig and
+ * auto_dvfs_headroom_enable, so it is done when one of them changes.
+ */
+void update_auto_fits_capacity(void)
+{
+	unsigned long flags;
+	bool dvfs_headroom;
+	int cpu;
+
+	raw_spin_lock_irqsave(&sched_auto_fits_lock, flags);
+
+	/* another cpu may have done it already */
+	if (!auto_fits_capacity_changed())
+		goto out;
+
+	dvfs_headroom = static_branch_likely(&auto_dvfs_headroom_enable);
+
+	write_seqcount_begin(&sched_auto_fits_seq);
+	for (cpu = 0; cpu < pixel_cpu_num; cpu++) {
+		unsigned long capacity = capacity_orig_of(cpu);
+		u64 limit = approximate_runtime(capacity) * USEC_PER_MSEC;
+
+		if (dvfs_headroom)
+			limit -= TICK_USEC;
+		else
+			limit = cap_scale(limit - TICK_USEC, capacity);
+		WRITE_ONCE(sched_auto_fits_capacity[cpu], approximate_util_avg(0, limit));
+		auto_fits_capacity_orig[cpu] = capacity;
+	}
+	auto_fits_dvfs_headroom = dvfs_headroom;
+	write_seqcount_end(&sched_auto_fits_seq);
+out:
+	raw_spin_unlock_irqrestore(&sched_auto_fits_lock, flags);
+}
+
+/* Called on tick, only catch capacity_orig changes of @cpu. */
+void check_auto_fits_capacity(int cpu)
+{
+	if (likely(READ_ONCE(auto_fits_capacity_orig[cpu]) == capacity_orig_of(cpu)))
+		return;
+
+	update_auto_fits_capacity();
+}
+
 static inline cpumask_t *get_group_cfs_skip_mask(struct task_struct *p)
 {
 	return &vg[get_vendor_group(p)].group_cfs_skip_mask;
@@ -613,7 +679,7 @@ static inline cpumask_t *get_group_cfs_skip_mask(struct task_struct *p)
 
 void init_vendor_group_data(void)
 {
-	int i;
+	int i, cpu;
 #if IS_ENABLED(CONFIG_USE_VENDOR_GROUP_UTIL)
 	int j;
 	struct rq *rq;
@@ -623,10 +689,12 @@ void init_vendor_group_data(void)
 	u64 last_update_time;
 #endif
 
-	for (i = 0; i < VG_MAX; i++) {
-		INIT_LIST_HEAD(&vendor_group_list[i].list);
-		raw_spin_lock_init(&vendor_group_list[i].lock);
-		vendor_group_list[i].cur_iterator = NULL;
+	for (cpu = 0; cpu < CONFIG_VH_SCHED_MAX_CPU_NR; cpu++) {
+		for (i = 0; i < VG_MAX; i++) {
+			INIT_LIST_HEAD(&vendor_group_list[cpu][i].list);
+			raw_spin_lock_init(&vendor_group_list[cpu][i].lock);
+			vendor_group_list[cpu][i].cur_iterator = NULL;
+		}
 	}
 
 #if IS_ENABLED(CONFIG_USE_VENDOR_GROUP_UTIL)
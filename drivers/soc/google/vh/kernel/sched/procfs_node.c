@@ -38,7 +38,7 @@ unsigned int __read_mostly vendor_sched_adpf_rampup_multiplier = 1;
 struct cpumask cpu_skip_mask_rt;
 static struct proc_dir_entry *vendor_sched;
 struct proc_dir_entry *group_dirs[VG_MAX];
-extern struct vendor_group_list vendor_group_list[VG_MAX];
+extern struct vendor_group_list vendor_group_list[CONFIG_VH_SCHED_MAX_CPU_NR][VG_MAX];
 
 static struct idle_inject_device *iidev_l;
 static struct idle_inject_device *iidev_m;
@@ -1296,30 +1296,31 @@ fail:
 	return -EINVAL;
 }
 
-static inline struct task_struct *get_next_task(int group, struct list_head *head)
+static inline struct task_struct *get_next_shard_task(struct vendor_group_list *vgl)
 {
 	unsigned long flags;
 	struct task_struct *p;
 	struct vendor_task_struct *vp;
+	struct list_head *head = &vgl->list;
 	struct list_head *cur;
 
-	raw_spin_lock_irqsave(&vendor_group_list[group].lock, flags);
+	raw_spin_lock_irqsave(&vgl->lock, flags);
 
 	if (list_empty(head)) {
-		vendor_group_list[group].cur_iterator = NULL;
-		raw_spin_unlock_irqrestore(&vendor_group_list[group].lock, flags);
+		vgl->cur_iterator = NULL;
+		raw_spin_unlock_irqrestore(&vgl->lock, flags);
 		return NULL;
 	}
 
-	if (vendor_group_list[group].cur_iterator)
-		cur = vendor_group_list[group].cur_iterator;
+	if (vgl->cur_iterator)
+		cur = vgl->cur_iterator;
 	else
 		cur = head;
 
 	do {
 		if (cur->next == head) {
-			vendor_group_list[group].cur_iterator = NULL;
-			raw_spin_unlock_irqrestore(&vendor_group_list[group].lock, flags);
+			vgl->cur_iterator = NULL;
+			raw_spin_unlock_irqrestore(&vgl->lock, flags);
 			return NULL;
 		}
 
@@ -1329,18 +1330,35 @@ static inline struct task_struct *get_next_task(int group, struct list_head *hea
 	} while ((!task_on_rq_queued(p) || p->flags & PF_EXITING));
 
 	get_task_struct(p);
-	vendor_group_list[group].cur_iterator = cur;
+	vgl->cur_iterator = cur;
 
-	raw_spin_unlock_irqrestore(&vendor_group_list[group].lock, flags);
+	raw_spin_unlock_irqrestore(&vgl->lock, flags);
 
 	return p;
 }
 
+/*
+ * Walk the cpu shards of the group, *cpu is the cursor of the shard being
+ * walked and each shard keeps its own position in cur_iterator.
+ */
+static inline struct task_struct *get_next_task(int group, int *cpu)
+{
+	struct task_struct *p;
+
+	for (; *cpu < pixel_cpu_num; (*cpu)++) {
+		p = get_next_shard_task(&vendor_group_list[*cpu][group]);
+		if (p)
+			return p;
+	}
+
+	return NULL;
+}
+
 static void apply_uclamp_change(enum vendor_group group, enum uclamp_id clamp_id)
 {
 	struct task_struct *p;
 	unsigned long flags;
-	struct list_head *head = &vendor_group_list[group].list;
+	int cpu;
 
 	if (trace_clock_set_rate_enabled()) {
 		char trace_name[32] = {0};
@@ -1351,11 +1369,14 @@ static void apply_uclamp_change(enum vendor_group group, enum uclamp_id clamp_id
 				raw_smp_processor_id());
 	}
 
-	raw_spin_lock_irqsave(&vendor_group_list[group].lock, flags);
-	vendor_group_list[group].cur_iterator = NULL;
-	raw_spin_unlock_irqrestore(&vendor_group_list[group].lock, flags);
+	for (cpu = 0; cpu < pixel_cpu_num; cpu++) {
+		raw_spin_lock_irqsave(&vendor_group_list[cpu][group].lock, flags);
+		vendor_group_list[cpu][group].cur_iterator = NULL;
+		raw_spin_unlock_irqrestore(&vendor_group_list[cpu][group].lock, flags);
+	}
 
-	while ((p = get_next_task(group, head))) {
+	cpu = 0;
+	while ((p = get_next_task(group, &cpu))) {
 		uclamp_update_active(p, clamp_id);
 		put_task_struct(p);
 	}
@@ -1493,8 +1514,8 @@ static int update_vendor_group_attribute(const char *buf, enum vendor_group_attr
 			migrate_vendor_group_util(p, old, new);
 #endif
 		if (vp->queued_to_list == LIST_QUEUED) {
-			remove_from_vendor_group_list(&vp->node, old);
-			add_to_vendor_group_list(&vp->node, new);
+			remove_from_vendor_group_list(&vp->node, old, vp->list_cpu);
+			add_to_vendor_group_list(&vp->node, new, vp->list_cpu);
 		}
 		vp->group = new;
 		raw_spin_unlock_irqrestore(&vp->lock, flags);
@@ -1514,8 +1535,8 @@ static int update_vendor_group_attribute(const char *buf, enum vendor_group_attr
 				continue;
 			}
 			if (vp->queued_to_list == LIST_QUEUED) {
-				remove_from_vendor_group_list(&vp->node, old);
-				add_to_vendor_group_list(&vp->node, new);
+				remove_from_vendor_group_list(&vp->node, old, vp->list_cpu);
+				add_to_vendor_group_list(&vp->node, new, vp->list_cpu);
 			}
 			vp->group = new;
 			raw_spin_unlock_irqrestore(&vp->lock, flags);
@@ -1746,6 +1767,8 @@ static ssize_t auto_dvfs_headroom_enable_store(struct file *filp,
 	else
 		static_branch_disable(&auto_dvfs_headroom_enable);
 
+	update_auto_fits_capacity();
+
 	return count;
 }
 PROC_OPS_RW(auto_dvfs_headroom_enable);
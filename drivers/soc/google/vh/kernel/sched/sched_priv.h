@@ -42,6 +42,7 @@
 
 extern unsigned int sched_capacity_margin[CONFIG_VH_SCHED_MAX_CPU_NR];
 extern unsigned int sched_auto_fits_capacity[CONFIG_VH_SCHED_MAX_CPU_NR];
+extern seqcount_raw_spinlock_t sched_auto_fits_seq;
 extern unsigned int sched_dvfs_headroom[CONFIG_VH_SCHED_MAX_CPU_NR];
 extern unsigned int sched_auto_uclamp_max[CONFIG_VH_SCHED_MAX_CPU_NR];
 extern unsigned int sched_per_cpu_iowait_boost_max_value[CONFIG_VH_SCHED_MAX_CPU_NR];
@@ -73,18 +74,19 @@ u64 approximate_runtime(unsigned long util);
 
 #define cap_scale(v, s) ((v)*(s) >> SCHED_CAPACITY_SHIFT)
 
-static inline void update_auto_fits_capacity(void)
+void update_auto_fits_capacity(void);
+void check_auto_fits_capacity(int cpu);
+
+static inline unsigned int get_auto_fits_capacity(int cpu)
 {
-	int cpu;
-
-	for (cpu = 0; cpu < pixel_cpu_num; cpu++) {
-		u64 limit = approximate_runtime(capacity_orig_of(cpu)) * USEC_PER_MSEC;
-		if (static_branch_likely(&auto_dvfs_headroom_enable))
-			limit -= TICK_USEC;
-		else
-			limit = cap_scale(limit - TICK_USEC, capacity_orig_of(cpu));
-		sched_auto_fits_capacity[cpu] = approximate_util_avg(0, limit);
-	}
+	unsigned int seq, capacity;
+
+	do {
+		seq = read_seqcount_begin(&sched_auto_fits_seq);
+		capacity = READ_ONCE(sched_auto_fits_capacity[cpu]);
+	} while (read_seqcount_retry(&sched_auto_fits_seq, seq));
+
+	return capacity;
 }
 
 /*
@@ -103,7 +105,7 @@ static inline void update_auto_fits_capacity(void)
 static inline bool fits_capacity(unsigned long util, unsigned long capacity, int cpu)
 {
 	if (static_branch_likely(&auto_migration_margins_enable))
-		return util < sched_auto_fits_capacity[cpu];
+		return util < get_auto_fits_capacity(cpu);
 	else
 		return !cpu_overutilized(util, capacity, cpu);
 }
@@ -127,18 +129,24 @@ static inline bool fits_capacity(unsigned long util, unsigned long capacity, int
 	void *__mptr = (void *)(ptr);				\
 	((type *)(__mptr - offsetof(type, member))); })
 
-#define remove_from_vendor_group_list(__node, __group) do {	\
-	raw_spin_lock(&vendor_group_list[__group].lock);	\
-	if (__node == vendor_group_list[__group].cur_iterator)	\
-		vendor_group_list[__group].cur_iterator = (__node)->prev;	\
-	list_del_init(__node);					\
-	raw_spin_unlock(&vendor_group_list[__group].lock);	\
+/*
+ * vendor_group_list is sharded per cpu so enqueue and dequeue only contend
+ * with the same rq. A queued task stays in the shard it was added to.
+ */
+#define remove_from_vendor_group_list(__node, __group, __cpu) do {	\
+	struct vendor_group_list *__vgl = &vendor_group_list[__cpu][__group];	\
+	raw_spin_lock(&__vgl->lock);					\
+	if (__node == __vgl->cur_iterator)				\
+		__vgl->cur_iterator = (__node)->prev;			\
+	list_del_init(__node);						\
+	raw_spin_unlock(&__vgl->lock);					\
 } while (0)
 
-#define add_to_vendor_group_list(__node, __group) do {		\
-	raw_spin_lock(&vendor_group_list[__group].lock);	\
-	list_add_tail(__node, &vendor_group_list[__group].list);	\
-	raw_spin_unlock(&vendor_group_list[__group].lock);	\
+#define add_to_vendor_group_list(__node, __group, __cpu) do {		\
+	struct vendor_group_list *__vgl = &vendor_group_list[__cpu][__group];	\
+	raw_spin_lock(&__vgl->lock);					\
+	list_add_tail(__node, &__vgl->list);				\
+	raw_spin_unlock(&__vgl->lock);					\
 } while (0)
 
 struct vendor_group_property {
@@ -563,6 +571,7 @@ static inline void init_vendor_task_struct(struct vendor_task_struct *v_tsk)
 	v_tsk->direct_reclaim_ts = 0;
 	INIT_LIST_HEAD(&v_tsk->node);
 	v_tsk->queued_to_list = LIST_NOT_QUEUED;
+	v_tsk->list_cpu = 0;
 	v_tsk->uclamp_fork_reset = false;
 	v_tsk->prefer_idle = false;
 	v_tsk->prefer_high_cap = false;
@@ -71,6 +71,8 @@ static LIST_HEAD(drvdata_list);
 #define S3C64XX_SPI_MODE_BUS_TSZ_HALFWORD	BIT(17)
 #define S3C64XX_SPI_MODE_BUS_TSZ_WORD		(2 << 17)
 #define S3C64XX_SPI_MODE_BUS_TSZ_MASK		(3 << 17)
+#define S3C64XX_SPI_MODE_RX_RDY_LVL		GENMASK(16, 11)
+#define S3C64XX_SPI_MODE_RX_RDY_LVL_SHIFT	11
 #define S3C64XX_SPI_MODE_SELF_LOOPBACK		BIT(3)
 #define S3C64XX_SPI_MODE_RXDMA_ON		BIT(2)
 #define S3C64XX_SPI_MODE_TXDMA_ON		BIT(1)
@@ -116,6 +118,7 @@ static LIST_HEAD(drvdata_list);
 #define S3C64XX_SPI_FBCLK_MSK			(3 << 0)
 
 #define FIFO_LVL_MASK(i) ((i)->port_conf->fifo_lvl_mask[i->port_id])
+#define FIFO_DEPTH(i) ((FIFO_LVL_MASK(i) >> 1) + 1)
 #define S3C64XX_SPI_ST_TX_DONE(v, i) (((v) & \
 				(1 << (i)->port_conf->tx_st_done)) ? 1 : 0)
 #define TX_FIFO_LVL(v, i) (((v) >> 6) & FIFO_LVL_MASK(i))
@@ -134,6 +137,7 @@ static LIST_HEAD(drvdata_list);
 
 #define RXBUSY    BIT(2)
 #define TXBUSY    BIT(3)
+#define PIOBUSY   BIT(4)
 
 #define SPI_DBG_MODE		(0x1 << 0)
 #define SPI_LOOPBACK_MODE	(0x1 << 1)
@@ -540,6 +544,94 @@ static inline void writesw_32(void __iomem *addr, const void *buffer,
 	}
 }
 
+/*
+ * Move as many words as the FIFOs allow for an interrupt-driven CPU transfer:
+ * drain whatever has arrived in the RX FIFO, then top the TX FIFO back up
+ * while keeping no more than a FIFO's worth of bytes in flight, so the RX
+ * FIFO can never overrun. The FIFO levels count bytes, the positions count
+ * words. Returns the number of words still to be received.
+ */
+static unsigned int s3c64xx_spi_pio_pump(struct s3c64xx_spi_driver_data *sdd)
+{
+	struct s3c64xx_spi_pio *pio = &sdd->pio;
+	void __iomem *regs = sdd->regs;
+	unsigned int bytes = sdd->cur_bpw / 8;
+	unsigned int n, room;
+	u32 status;
+
+	status = readl(regs + S3C64XX_SPI_STATUS);
+	n = RX_FIFO_LVL(status, sdd) / bytes;
+	n = min(n, pio->tx_pos - pio->rx_pos);
+	if (n && pio->rx_buf) {
+		void *buf = pio->rx_buf + pio->rx_pos * bytes;
+
+		switch (sdd->cur_bpw) {
+		case 32:
+			ioread32_rep(regs + S3C64XX_SPI_RX_DATA, buf, n);
+			break;
+		case 16:
+			ioread16_rep(regs + S3C64XX_SPI_RX_DATA, buf, n);
+			break;
+		default:
+			ioread8_rep(regs + S3C64XX_SPI_RX_DATA, buf, n);
+			break;
+		}
+	} else {
+		unsigned int i;
+
+		for (i = 0; i < n; i++)
+			readl(regs + S3C64XX_SPI_RX_DATA);
+	}
+	pio->rx_pos += n;
+
+	/* never push more than the TX FIFO has room for */
+	room = FIFO_DEPTH(sdd) - TX_FIFO_LVL(status, sdd);
+	n = FIFO_DEPTH(sdd) / bytes - (pio->tx_pos - pio->rx_pos);
+	n = min3(n, room / bytes, pio->len - pio->tx_pos);
+	if (n && pio->tx_buf) {
+		const void *buf = pio->tx_buf + pio->tx_pos * bytes;
+
+		switch (sdd->cur_bpw) {
+		case 32:
+			iowrite32_rep(regs + S3C64XX_SPI_TX_DATA, buf, n);
+			break;
+		case 16:
+			writesw_32(regs + S3C64XX_SPI_TX_DATA, buf, n);
+			break;
+		default:
+			writesb_32(regs + S3C64XX_SPI_TX_DATA, buf, n);
+			break;
+		}
+	} else {
+		unsigned int i;
+
+		for (i = 0; i < n; i++)
+			writel(0, regs + S3C64XX_SPI_TX_DATA);
+	}
+	pio->tx_pos += n;
+
+	return pio->len - pio->rx_pos;
+}
+
+/*
+ * RX_RDY_LVL to raise the next FIFO-ready interrupt at: half a FIFO while the
+ * transfer streams, or whatever is left in flight towards the end. Like the
+ * FIFO levels the field counts bytes, in units of FIFO_DEPTH / 64 bytes on the
+ * deeper FIFOs. Returns 0 once the remainder is below one unit; the caller
+ * then finishes it by polling.
+ */
+static u32 s3c64xx_spi_pio_rdy_lvl(struct s3c64xx_spi_driver_data *sdd)
+{
+	struct s3c64xx_spi_pio *pio = &sdd->pio;
+	unsigned int unit = max_t(unsigned int, FIFO_DEPTH(sdd) / 64, 1);
+	unsigned int len;
+
+	len = (pio->tx_pos - pio->rx_pos) * (sdd->cur_bpw / 8);
+	len = min_t(unsigned int, len, FIFO_DEPTH(sdd) / 2);
+
+	return len / unit;
+}
+
 static void enable_datapath(struct s3c64xx_spi_driver_data *sdd,
 			    struct spi_device *spi,
 			    struct spi_transfer *xfer, int dma_mode)
@@ -583,8 +675,14 @@ static void enable_datapath(struct s3c64xx_spi_driver_data *sdd,
 	modecfg = readl(regs + S3C64XX_SPI_MODE_CFG);
 	modecfg &= ~(S3C64XX_SPI_MODE_TXDMA_ON | S3C64XX_SPI_MODE_RXDMA_ON);
 
-	if (xfer->tx_buf) {
-		sdd->state |= TXBUSY;
+	/*
+	 * Interrupt-driven transfers always run the TX channel, shifting out
+	 * zeroes for Rx-only xfers, so that the RX FIFO fills no faster than
+	 * the CPU refills the TX FIFO.
+	 */
+	if (xfer->tx_buf || (sdd->state & PIOBUSY)) {
+		if (xfer->tx_buf)
+			sdd->state |= TXBUSY;
 		chcfg |= S3C64XX_SPI_CH_TXCH_ON;
 
 		if (cs->cs_mode == MANUAL_CS_MODE && cs->cs_delay && !spi->cs_gpiod) {
@@ -595,6 +693,8 @@ static void enable_datapath(struct s3c64xx_spi_driver_data *sdd,
 		if (dma_mode) {
 			modecfg |= S3C64XX_SPI_MODE_TXDMA_ON;
 			prepare_dma(&sdd->tx_dma, xfer->len, xfer->tx_dma);
+		} else if (sdd->state & PIOBUSY) {
+			s3c64xx_spi_pio_pump(sdd);
 		} else {
 			switch (sdd->cur_bpw) {
 			case 32:
@@ -631,8 +731,19 @@ static void enable_datapath(struct s3c64xx_spi_driver_data *sdd,
 		}
 	}
 
+	if (sdd->state & PIOBUSY) {
+		modecfg &= ~S3C64XX_SPI_MODE_RX_RDY_LVL;
+		modecfg |= s3c64xx_spi_pio_rdy_lvl(sdd) <<
+				S3C64XX_SPI_MODE_RX_RDY_LVL_SHIFT;
+	}
+
 	writel(modecfg, regs + S3C64XX_SPI_MODE_CFG);
 	writel(chcfg, regs + S3C64XX_SPI_CH_CFG);
+
+	if (sdd->state & PIOBUSY)
+		writel(readl(regs + S3C64XX_SPI_INT_EN) |
+				S3C64XX_SPI_INT_RX_FIFORDY_EN,
+				regs + S3C64XX_SPI_INT_EN);
 }
 
 static inline void enable_cs(struct s3c64xx_spi_driver_data *sdd,
@@ -676,6 +787,54 @@ static inline void enable_cs(struct s3c64xx_spi_driver_data *sdd,
 	}
 }
 
+static int xfer_timeout_ms(struct s3c64xx_spi_driver_data *sdd,
+			   struct spi_transfer *xfer)
+{
+	int ms;
+
+	/* millisecs to xfer 'len' bytes @ 'cur_speed' */
+	ms = xfer->len * 8 * 1000 / sdd->cur_speed;
+	ms = (ms * 10) + 30; /* some tolerance */
+	return max(ms, 100); /* minimum timeout */
+}
+
+static int wait_for_pio(struct s3c64xx_spi_driver_data *sdd,
+			struct spi_transfer *xfer)
+{
+	void __iomem *regs = sdd->regs;
+	unsigned long val, flags;
+	bool timedout;
+
+	val = msecs_to_jiffies(xfer_timeout_ms(sdd, xfer)) + 10;
+	wait_for_completion_timeout(&sdd->xfer_completion, val);
+
+	/* The IRQ handler clears PIOBUSY once it hands over the tail */
+	spin_lock_irqsave(&sdd->lock, flags);
+	timedout = sdd->state & PIOBUSY;
+	if (timedout) {
+		writel(readl(regs + S3C64XX_SPI_INT_EN) &
+				~S3C64XX_SPI_INT_RX_FIFORDY_EN,
+				regs + S3C64XX_SPI_INT_EN);
+		sdd->state &= ~PIOBUSY;
+	}
+	spin_unlock_irqrestore(&sdd->lock, flags);
+
+	if (timedout)
+		return -EIO;
+
+	/* The last few words are below one RX_RDY_LVL unit */
+	val = msecs_to_loops(10);
+	while (s3c64xx_spi_pio_pump(sdd) && --val)
+		cpu_relax();
+
+	if (!val)
+		return -EIO;
+
+	sdd->state &= ~(TXBUSY | RXBUSY);
+
+	return 0;
+}
+
 static int wait_for_xfer(struct s3c64xx_spi_driver_data *sdd,
 			 struct spi_transfer *xfer, int dma_mode)
 {
@@ -683,10 +842,7 @@ static int wait_for_xfer(struct s3c64xx_spi_driver_data *sdd,
 	unsigned long val;
 	int ms;
 
-	/* millisecs to xfer 'len' bytes @ 'cur_speed' */
-	ms = xfer->len * 8 * 1000 / sdd->cur_speed;
-	ms = (ms * 10) + 30; /* some tolerance */
-	ms = max(ms, 100); /* minimum timeout */
+	ms = xfer_timeout_ms(sdd, xfer);
 
 	if (dma_mode) {
 		val = msecs_to_jiffies(ms) + 10;
@@ -714,6 +870,19 @@ static int wait_for_xfer(struct s3c64xx_spi_driver_data *sdd,
 		 * Xfer involved Rx(with or without Tx).
 		 */
 		if (!xfer->rx_buf) {
+			unsigned long us;
+
+			/*
+			 * Sleep through most of the time the words still in
+			 * the TX FIFO need on the bus instead of spinning.
+			 */
+			status = readl(regs + S3C64XX_SPI_STATUS);
+			us = div_u64((u64)TX_FIFO_LVL(status, sdd) *
+				     sdd->cur_bpw * USEC_PER_SEC,
+				     sdd->cur_speed);
+			if (us > 20)
+				usleep_range(us - us / 4, us);
+
 			val = msecs_to_loops(10);
 			status = readl(regs + S3C64XX_SPI_STATUS);
 			while ((TX_FIFO_LVL(status, sdd) ||
@@ -905,7 +1074,7 @@ static int s3c64xx_spi_map_one_msg(struct s3c64xx_spi_driver_data *sdd,
 	if (msg->is_dma_mapped || sci->dma_mode != DMA_MODE)
 		return 0;
 
-	if (xfer->len <= ((FIFO_LVL_MASK(sdd) >> 1) + 1))
+	if (xfer->len <= sdd->dma_min_len)
 		return 0;
 
 	if (xfer->tx_buf) {
@@ -945,7 +1114,7 @@ static void s3c64xx_spi_unmap_one_msg(struct s3c64xx_spi_driver_data *sdd,
 	if (msg->is_dma_mapped || sci->dma_mode != DMA_MODE)
 		return;
 
-	if (xfer->len <= ((FIFO_LVL_MASK(sdd) >> 1) + 1))
+	if (xfer->len <= sdd->dma_min_len)
 		return;
 
 	if (xfer->rx_buf && xfer->rx_dma != DMA_MAPPING_ERROR)
@@ -993,7 +1162,7 @@ static int s3c64xx_spi_transfer_one_message(struct spi_master *master,
 
 	list_for_each_entry(xfer, &msg->transfers, transfer_list) {
 		unsigned long flags;
-		int use_dma;
+		int use_dma, use_pio;
 
 		reinit_completion(&sdd->xfer_completion);
 
@@ -1014,31 +1183,17 @@ static int s3c64xx_spi_transfer_one_message(struct spi_master *master,
 			s3c64xx_spi_config(sdd);
 		}
 
-		/* verify cpu mode */
-		if (sci->dma_mode != DMA_MODE) {
-			use_dma = 0;
+		/* backup original tx, rx buf ptr & xfer length */
+		origin_tx_buf = xfer->tx_buf;
+		origin_rx_buf = xfer->rx_buf;
+		origin_len = xfer->len;
 
-			/* backup original tx, rx buf ptr & xfer length */
-			origin_tx_buf = xfer->tx_buf;
-			origin_rx_buf = xfer->rx_buf;
-			origin_len = xfer->len;
-
-			target_len = xfer->len;
-			if (xfer->len > fifo_lvl)
-				xfer->len = fifo_lvl;
-		} else {
-			/* backup original tx, rx buf ptr & xfer length */
-			origin_tx_buf = xfer->tx_buf;
-			origin_rx_buf = xfer->rx_buf;
-			origin_len = xfer->len;
-
-			target_len = xfer->len;
-			if (xfer->len > S3C64XX_SPI_PACKET_CNT_MAX *
-					sdd->cur_bpw / 8)
-				xfer->len = S3C64XX_SPI_PACKET_CNT_MAX *
-					sdd->cur_bpw / 8;
-		}
+		target_len = xfer->len;
+		if (xfer->len > S3C64XX_SPI_PACKET_CNT_MAX * sdd->cur_bpw / 8)
+			xfer->len = S3C64XX_SPI_PACKET_CNT_MAX *
+				sdd->cur_bpw / 8;
 try_transfer:
+		use_dma = 0;
 		if (sci->dma_mode == DMA_MODE) {
 			/* Map the transfer if needed */
 			if (s3c64xx_spi_map_one_msg(sdd, msg, xfer)) {
@@ -1047,22 +1202,32 @@ try_transfer:
 				goto out;
 			}
 
-			/*
-			 * Polling method for xfers not bigger than FIFO
-			 * capacity
-			 */
-			if (xfer->len <= fifo_lvl)
-				use_dma = 0;
-			else
+			/* CPU transfer for xfers cheaper than a DMA setup */
+			if (xfer->len > sdd->dma_min_len)
 				use_dma = 1;
 		}
 
+		/*
+		 * Polling method for xfers not bigger than FIFO capacity,
+		 * FIFO-level interrupts refill and drain anything larger.
+		 */
+		use_pio = !use_dma && xfer->len > fifo_lvl;
+
 		spin_lock_irqsave(&sdd->lock, flags);
 
 		/* Pending only which is to be done */
 		sdd->state &= ~RXBUSY;
 		sdd->state &= ~TXBUSY;
 
+		if (use_pio) {
+			sdd->pio.tx_buf = xfer->tx_buf;
+			sdd->pio.rx_buf = xfer->rx_buf;
+			sdd->pio.len = xfer->len / (sdd->cur_bpw / 8);
+			sdd->pio.tx_pos = 0;
+			sdd->pio.rx_pos = 0;
+			sdd->state |= PIOBUSY;
+		}
+
 		if (cs->cs_mode == AUTO_CS_MODE ||
 		    cs->cs_mode == AUTO_CS_MODE_FORCE_QUIESCE ||
 		    (cs->cs_mode == MANUAL_CS_MODE && cs->cs_delay && !spi->cs_gpiod)) {
@@ -1079,7 +1244,10 @@ try_transfer:
 
 		spin_unlock_irqrestore(&sdd->lock, flags);
 
-		status = wait_for_xfer(sdd, xfer, use_dma);
+		if (use_pio)
+			status = wait_for_pio(sdd, xfer);
+		else
+			status = wait_for_xfer(sdd, xfer, use_dma);
 
 		if (status) {
 			dev_err(&spi->dev, "I/O Error: rx-%d tx-%d res:rx-%c tx-%c len-%d\n",
@@ -1121,53 +1289,31 @@ try_transfer:
 
 		flush_fifo(sdd);
 
-		if (sci->dma_mode != DMA_MODE) {
-			target_len -= xfer->len;
-
-			if (xfer->tx_buf)
-				xfer->tx_buf += xfer->len;
-
-			if (xfer->rx_buf)
-				xfer->rx_buf += xfer->len;
-
-			if (target_len > 0) {
-				if (target_len > fifo_lvl)
-					xfer->len = fifo_lvl;
-				else
-					xfer->len = target_len;
-				goto try_transfer;
-			}
-
-			/* restore original tx, rx buf_ptr & xfer length */
-			xfer->tx_buf = origin_tx_buf;
-			xfer->rx_buf = origin_rx_buf;
-			xfer->len = origin_len;
-		} else {
+		if (sci->dma_mode == DMA_MODE)
 			s3c64xx_spi_unmap_one_msg(sdd, msg, xfer);
 
-			target_len -= xfer->len;
-
-			if (xfer->tx_buf)
-				xfer->tx_buf += xfer->len;
+		target_len -= xfer->len;
 
-			if (xfer->rx_buf)
-				xfer->rx_buf += xfer->len;
+		if (xfer->tx_buf)
+			xfer->tx_buf += xfer->len;
 
-			if (target_len > 0) {
-				if (target_len > S3C64XX_SPI_PACKET_CNT_MAX *
-						sdd->cur_bpw / 8)
-					xfer->len = S3C64XX_SPI_PACKET_CNT_MAX *
-						sdd->cur_bpw / 8;
-				else
-					xfer->len = target_len;
-				goto try_transfer;
-			}
+		if (xfer->rx_buf)
+			xfer->rx_buf += xfer->len;
 
-			/* restore original tx, rx buf_ptr & xfer length */
-			xfer->tx_buf = origin_tx_buf;
-			xfer->rx_buf = origin_rx_buf;
-			xfer->len = origin_len;
+		if (target_len > 0) {
+			if (target_len > S3C64XX_SPI_PACKET_CNT_MAX *
+					sdd->cur_bpw / 8)
+				xfer->len = S3C64XX_SPI_PACKET_CNT_MAX *
+					sdd->cur_bpw / 8;
+			else
+				xfer->len = target_len;
+			goto try_transfer;
 		}
+
+		/* restore original tx, rx buf_ptr & xfer length */
+		xfer->tx_buf = origin_tx_buf;
+		xfer->rx_buf = origin_rx_buf;
+		xfer->len = origin_len;
 	}
 
 out:
@@ -1415,6 +1561,31 @@ static irqreturn_t s3c64xx_spi_irq(int irq, void *data)
 		dev_err(&spi->dev, "TX underrun\n");
 	}
 
+	if (val & S3C64XX_SPI_ST_RX_FIFORDY) {
+		u32 lvl = 0, cfg;
+
+		spin_lock(&sdd->lock);
+		if (sdd->state & PIOBUSY) {
+			if (s3c64xx_spi_pio_pump(sdd))
+				lvl = s3c64xx_spi_pio_rdy_lvl(sdd);
+
+			if (lvl) {
+				cfg = readl(sdd->regs + S3C64XX_SPI_MODE_CFG);
+				cfg &= ~S3C64XX_SPI_MODE_RX_RDY_LVL;
+				cfg |= lvl << S3C64XX_SPI_MODE_RX_RDY_LVL_SHIFT;
+				writel(cfg, sdd->regs + S3C64XX_SPI_MODE_CFG);
+			} else {
+				/* FIFO_RDY has no pending bit, mask it instead */
+				cfg = readl(sdd->regs + S3C64XX_SPI_INT_EN);
+				cfg &= ~S3C64XX_SPI_INT_RX_FIFORDY_EN;
+				writel(cfg, sdd->regs + S3C64XX_SPI_INT_EN);
+				sdd->state &= ~PIOBUSY;
+				complete(&sdd->xfer_completion);
+			}
+		}
+		spin_unlock(&sdd->lock);
+	}
+
 	/* Clear the pending irq by setting and then clearing it */
 	writel(clr, sdd->regs + S3C64XX_SPI_PENDING_CLR);
 	writel(0, sdd->regs + S3C64XX_SPI_PENDING_CLR);
@@ -1783,6 +1954,16 @@ static int s3c64xx_spi_probe(struct platform_device *pdev)
 				sdd->port_conf->fifo_lvl_mask[sdd->port_id]);
 	}
 
+	/*
+	 * Transfers up to a FIFO are moved by the CPU even in DMA mode, as
+	 * before. Ports that measure a later crossover can raise it from DT.
+	 */
+	if (of_property_read_u32(pdev->dev.of_node, "samsung,spi-dma-min-len",
+				 &sdd->dma_min_len))
+		sdd->dma_min_len = FIFO_DEPTH(sdd);
+	sdd->dma_min_len = max_t(unsigned int, sdd->dma_min_len,
+				  FIFO_DEPTH(sdd));
+
 	exynos_usi_init(sdd);
 
 	/* Setup Deufult Mode */
@@ -225,6 +225,23 @@ static struct acpm_gov_common acpm_gov_common = {
 	.bulk_trace_buffer = NULL,
 };
 
+/*
+ * Snapshot of all zone temperatures read out of the ACPM governor shared
+ * memory. When epoch_ms is non-zero, zone reads within one epoch are served
+ * from the snapshot instead of issuing one ACPM IPC per zone.
+ */
+#define BULK_TEMP_MIN		1
+#define BULK_TEMP_MAX		125
+
+static struct {
+	spinlock_t lock;
+	u32 epoch_ms;
+	u64 ts;
+	u8 temp[NR_TZ];
+} bulk_temp = {
+	.lock = __SPIN_LOCK_UNLOCKED(bulk_temp.lock),
+};
+
 static const char * const trace_suffix[] = {
 	[CPU_THROTTLE] = "cpu_throttle",
 	[HARD_LIMIT] = "hard_limit",
@@ -335,6 +352,58 @@ static bool get_all_curr_state_from_acpm(void __iomem *base, struct curr_state *
 	}
 }
 
+/**
+ * get_bulk_temp() - read a zone temperature from the shared memory snapshot
+ * @id: thermal zone id
+ * @sample_ms: ACPM governor timer interval of the zone
+ * @temp: temperature in degrees Celsius
+ *
+ * The snapshot of all zones is refreshed at most once per epoch with a single
+ * copy from ACPM shared memory. curr_state carries no sample time and ACPM
+ * may have written a zone up to @sample_ms before the copy, so a snapshot is
+ * only served for the epoch minus @sample_ms. Zones sampled once per epoch
+ * or slower always read through IPC. Values the u8 field cannot represent
+ * reliably are not served from the snapshot.
+ *
+ * Return: true if @temp was filled in, false if the caller has to read the
+ * temperature through IPC.
+ */
+static bool get_bulk_temp(int id, u32 sample_ms, int *temp)
+{
+	struct curr_state curr_state_all[NR_TZ];
+	struct curr_state *curr_state_ptr = curr_state_all;
+	u32 epoch_ms = READ_ONCE(bulk_temp.epoch_ms);
+	u64 now;
+	u8 val;
+	int i;
+
+	if (!epoch_ms || !acpm_gov_common.turn_on || ACPM_BUF_VER != EXPECT_BUF_VER ||
+	    id >= NR_TZ || sample_ms >= epoch_ms)
+		return false;
+
+	now = ktime_get_boottime_ns();
+
+	spin_lock(&bulk_temp.lock);
+	if (!bulk_temp.ts ||
+	    now - bulk_temp.ts >= (u64)(epoch_ms - sample_ms) * NSEC_PER_MSEC) {
+		if (!get_all_curr_state_from_acpm(acpm_gov_common.sm_base, &curr_state_ptr)) {
+			spin_unlock(&bulk_temp.lock);
+			return false;
+		}
+		for (i = 0; i < NR_TZ; i++)
+			bulk_temp.temp[i] = curr_state_all[i].temperature;
+		bulk_temp.ts = now;
+	}
+	val = bulk_temp.temp[id];
+	spin_unlock(&bulk_temp.lock);
+
+	if (val < BULK_TEMP_MIN || val > BULK_TEMP_MAX)
+		return false;
+
+	*temp = val;
+	return true;
+}
+
 #if IS_ENABLED(CONFIG_PIXEL_METRICS)
 static struct gs_tmu_data* get_tr_handle_tmu_data(tr_handle instance)
 {
@@ -1050,7 +1119,8 @@ static int gs_get_temp(struct thermal_zone_device *tz, int *temp)
 
 	mutex_lock(&data->lock);
 
-	exynos_acpm_tmu_set_read_temp(data->id, &acpm_temp, &stat);
+	if (!get_bulk_temp(data->id, data->polling_delay_on, &acpm_temp))
+		exynos_acpm_tmu_set_read_temp(data->id, &acpm_temp, &stat);
 
 	*temp = acpm_temp * MCELSIUS;
 
@@ -2877,6 +2947,38 @@ static const struct kernel_param_ops param_ops_acpm_gov_last_ts = {
 
 module_param_cb(acpm_gov_last_ts, &param_ops_acpm_gov_last_ts, NULL, 0644);
 
+static int param_acpm_gov_bulk_temp_epoch_ms_get(char *buf, const struct kernel_param *kp)
+{
+	return sysfs_emit(buf, "%u\n", bulk_temp.epoch_ms);
+}
+
+static int param_acpm_gov_bulk_temp_epoch_ms_set(const char *val, const struct kernel_param *kp)
+{
+	u32 epoch_ms;
+
+	if (kstrtou32(val, 10, &epoch_ms)) {
+		pr_err("%s: bulk_temp_epoch_ms parse error", __func__);
+		return -EINVAL;
+	}
+
+	if (epoch_ms && acpm_gov_common.turn_on == false)
+		return -EINVAL;
+
+	spin_lock(&bulk_temp.lock);
+	bulk_temp.epoch_ms = epoch_ms;
+	bulk_temp.ts = 0;
+	spin_unlock(&bulk_temp.lock);
+
+	return 0;
+}
+
+static const struct kernel_param_ops param_ops_acpm_gov_bulk_temp_epoch_ms = {
+	.get = param_acpm_gov_bulk_temp_epoch_ms_get,
+	.set = param_acpm_gov_bulk_temp_epoch_ms_set,
+};
+
+module_param_cb(acpm_gov_bulk_temp_epoch_ms, &param_ops_acpm_gov_bulk_temp_epoch_ms, NULL, 0644);
+
 static int param_acpm_gov_tracing_mode_get(char *buf, const struct kernel_param *kp)
 {
 	return sysfs_emit(buf, "%d\n", acpm_gov_common.tracing_mode);
@@ -5382,6 +5484,9 @@ static int parse_acpm_gov_common_dt(void)
 		acpm_gov_common.thermal_pressure.polling_delay_off =
 			ACPM_GOV_THERMAL_PRESS_POLLING_DELAY_OFF;
 
+	/* optional, zone temperatures are read through IPC when absent */
+	of_property_read_u32(np, "bulk_temp_epoch_ms", &bulk_temp.epoch_ms);
+
 	return 0;
 }
 
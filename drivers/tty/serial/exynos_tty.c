@@ -23,6 +23,7 @@
 
 #include <linux/dmaengine.h>
 #include <linux/dma-mapping.h>
+#include <linux/amba/pl330.h>
 #include <linux/slab.h>
 #include <linux/module.h>
 #include <linux/ioport.h>
@@ -123,6 +124,10 @@ struct exynos_uart_dma {
 
 	int				tx_bytes_requested;
 	int				rx_bytes_requested;
+
+	/* RX runs as a never-ending ring on PL330 channels */
+	bool				rx_cyclic;
+	size_t				rx_tail;
 };
 
 struct uart_local_buf {
@@ -215,6 +220,20 @@ static unsigned int rd_reg(struct uart_port *port, int reg)
 
 #define rd_regl(port, reg) (readl_relaxed(portaddr(port, reg)))
 
+static void rd_reg_rep(struct uart_port *port, int reg, unsigned char *buf,
+		       unsigned int count)
+{
+	switch (port->iotype) {
+	case UPIO_MEM:
+		readsb(portaddr(port, reg), buf, count);
+		break;
+	case UPIO_MEM32:
+		while (count--)
+			*buf++ = readl_relaxed(portaddr(port, reg));
+		break;
+	}
+}
+
 static void wr_reg(struct uart_port *port, int reg, int val)
 {
 	switch (port->iotype) {
@@ -268,6 +287,9 @@ static inline void exynos_clear_bit(struct uart_port *port, int idx,
 #define EXYNOS_RX_PIO			1
 #define EXYNOS_RX_DMA			2
 
+/* The cyclic RX ring raises a completion every 1/Nth of the buffer */
+#define EXYNOS_RX_DMA_PERIODS		4
+
 /* Baudrate definition*/
 #define MAX_BAUD	4000000
 #define MIN_BAUD	0
@@ -929,7 +951,7 @@ static void exynos_serial_unthrottle(struct uart_port *port)
 }
 
 static void exynos_uart_copy_rx_to_tty(struct exynos_uart_port *ourport, struct
-				       tty_port * tty, int count)
+				       tty_port * tty, size_t offset, int count)
 {
 	struct exynos_uart_dma *dma = ourport->dma;
 	int copied;
@@ -937,8 +959,8 @@ static void exynos_uart_copy_rx_to_tty(struct exynos_uart_port *ourport, struct
 	if (!count)
 		return;
 
-	dma_sync_single_for_cpu(ourport->port.dev, dma->rx_addr,
-				dma->rx_size, DMA_FROM_DEVICE);
+	dma_sync_single_range_for_cpu(ourport->port.dev, dma->rx_addr,
+				      offset, count, DMA_FROM_DEVICE);
 
 	ourport->port.icount.rx += count;
 	if (!tty) {
@@ -948,17 +970,20 @@ static void exynos_uart_copy_rx_to_tty(struct exynos_uart_port *ourport, struct
 
 	if (ourport->uart_logging && count)
 		uart_copy_to_local_buf(1, &ourport->uart_local_buf,
-				       ourport->dma->rx_buf, count);
+				       ourport->dma->rx_buf + offset, count);
 
 	copied = tty_insert_flip_string(tty,
-					(unsigned char *)ourport->dma->rx_buf,
-					count);
+					(unsigned char *)ourport->dma->rx_buf +
+					offset, count);
 	if (copied != count) {
 		WARN_ON(1);
 		dev_err(ourport->port.dev, "RxData copy to tty layer failed\n");
 	}
 }
 
+static void exynos_serial_rx_dma_flush(struct exynos_uart_port *ourport);
+static void enable_rx_pio(struct exynos_uart_port *ourport);
+
 static void exynos_serial_stop_rx(struct uart_port *port)
 {
 	struct exynos_uart_port *ourport = to_ourport(port);
@@ -976,14 +1001,20 @@ static void exynos_serial_stop_rx(struct uart_port *port)
 			disable_irq_nosync(ourport->rx_irq);
 		ourport->rx_enabled = 0;
 	}
-	if (dma && dma->rx_chan) {
+	if (dma && dma->rx_chan && dma->rx_cyclic) {
+		if (ourport->rx_mode == EXYNOS_RX_DMA) {
+			exynos_serial_rx_dma_flush(ourport);
+			dmaengine_terminate_all(dma->rx_chan);
+			enable_rx_pio(ourport);
+		}
+	} else if (dma && dma->rx_chan) {
 		dmaengine_pause(dma->tx_chan);
 		dma_status = dmaengine_tx_status(dma->rx_chan, dma->rx_cookie,
 						 &state);
 		if (dma_status == DMA_IN_PROGRESS || dma_status == DMA_PAUSED) {
 			received = dma->rx_bytes_requested - state.residue;
 			dmaengine_terminate_all(dma->rx_chan);
-			exynos_uart_copy_rx_to_tty(ourport, t, received);
+			exynos_uart_copy_rx_to_tty(ourport, t, 0, received);
 		}
 	}
 }
@@ -1038,7 +1069,7 @@ static void exynos_serial_rx_dma_complete(void *args)
 	spin_lock_irqsave(&port->lock, flags);
 
 	if (received)
-		exynos_uart_copy_rx_to_tty(ourport, t, received);
+		exynos_uart_copy_rx_to_tty(ourport, t, 0, received);
 
 	if (tty) {
 		tty_flip_buffer_push(t);
@@ -1050,10 +1081,103 @@ static void exynos_serial_rx_dma_complete(void *args)
 	spin_unlock_irqrestore(&port->lock, flags);
 }
 
+/*
+ * Hand everything the cyclic RX DMA wrote since the last flush over to the
+ * tty layer. The PL330 destination address is the ring's write pointer, so
+ * this works at any point, not only on period boundaries. Called with
+ * port->lock held.
+ */
+static void exynos_serial_rx_dma_flush(struct exynos_uart_port *ourport)
+{
+	struct exynos_uart_dma *dma = ourport->dma;
+	struct tty_port *t = &ourport->port.state->port;
+	dma_addr_t src, dst;
+	size_t head, count;
+
+	if (!IS_REACHABLE(CONFIG_PL330_DMA_GS) ||
+	    pl330_dma_getposition(dma->rx_chan, &src, &dst))
+		return;
+
+	/* DAR reads zero until the first DMAMOV has executed */
+	if (dst < dma->rx_addr || dst > dma->rx_addr + dma->rx_size)
+		return;
+
+	head = (dst - dma->rx_addr) % dma->rx_size;
+	if (head == dma->rx_tail)
+		return;
+
+	if (head < dma->rx_tail) {
+		count = dma->rx_size - dma->rx_tail;
+		exynos_uart_copy_rx_to_tty(ourport, t, dma->rx_tail, count);
+		dma_sync_single_range_for_device(ourport->port.dev,
+						 dma->rx_addr, dma->rx_tail,
+						 count, DMA_FROM_DEVICE);
+		dma->rx_tail = 0;
+	}
+
+	count = head - dma->rx_tail;
+	exynos_uart_copy_rx_to_tty(ourport, t, dma->rx_tail, count);
+	dma_sync_single_range_for_device(ourport->port.dev, dma->rx_addr,
+					 dma->rx_tail, count, DMA_FROM_DEVICE);
+	dma->rx_tail = head;
+
+	tty_flip_buffer_push(t);
+}
+
+static void exynos_serial_rx_dma_period(void *args)
+{
+	struct exynos_uart_port *ourport = args;
+	struct uart_port *port = &ourport->port;
+	unsigned long flags;
+
+	spin_lock_irqsave(&port->lock, flags);
+
+	if (ourport->rx_mode == EXYNOS_RX_DMA)
+		exynos_serial_rx_dma_flush(ourport);
+
+	spin_unlock_irqrestore(&port->lock, flags);
+}
+
+static void exynos_serial_start_rx_cyclic(struct exynos_uart_port *ourport)
+{
+	struct exynos_uart_dma *dma = ourport->dma;
+	unsigned int infiniteloop = 0;
+
+	if (!IS_REACHABLE(CONFIG_PL330_DMA_GS))
+		return;
+
+	dma_sync_single_for_device(ourport->port.dev, dma->rx_addr,
+				   dma->rx_size, DMA_FROM_DEVICE);
+
+	dma->rx_desc = __pl330_prep_dma_cyclic(dma->rx_chan, dma->rx_addr,
+					       dma->rx_size,
+					       dma->rx_size /
+					       EXYNOS_RX_DMA_PERIODS,
+					       DMA_DEV_TO_MEM,
+					       DMA_PREP_INTERRUPT,
+					       &infiniteloop);
+	if (!dma->rx_desc) {
+		dev_err(ourport->port.dev, "Unable to get cyclic desc for Rx\n");
+		return;
+	}
+
+	dma->rx_desc->callback = exynos_serial_rx_dma_period;
+	dma->rx_desc->callback_param = ourport;
+	dma->rx_tail = 0;
+
+	dma->rx_cookie = dmaengine_submit(dma->rx_desc);
+	dma_async_issue_pending(dma->rx_chan);
+}
+
 static void s3c64xx_start_rx_dma(struct exynos_uart_port *ourport)
 {
 	struct exynos_uart_dma *dma = ourport->dma;
 
+	if (dma->rx_cyclic) {
+		exynos_serial_start_rx_cyclic(ourport);
+		return;
+	}
+
 	dma_sync_single_for_device(ourport->port.dev, dma->rx_addr,
 				   dma->rx_size, DMA_FROM_DEVICE);
 
@@ -1156,12 +1280,19 @@ static irqreturn_t exynos_serial_rx_chars_dma(void *dev_id)
 		goto finish;
 	}
 
+	/* The ring keeps running, only the tail since the last period is due */
+	if (ourport->rx_mode == EXYNOS_RX_DMA && dma->rx_cyclic) {
+		exynos_serial_rx_dma_flush(ourport);
+		wr_regl(port, S3C64XX_UINTP, S3C64XX_UINTM_RXD_MSK);
+		goto finish;
+	}
+
 	if (ourport->rx_mode == EXYNOS_RX_DMA) {
 		dmaengine_pause(dma->rx_chan);
 		dmaengine_tx_status(dma->rx_chan, dma->rx_cookie, &state);
 		dmaengine_terminate_all(dma->rx_chan);
 		received = dma->rx_bytes_requested - state.residue;
-		exynos_uart_copy_rx_to_tty(ourport, t, received);
+		exynos_uart_copy_rx_to_tty(ourport, t, 0, received);
 
 		enable_rx_pio(ourport);
 	}
@@ -1176,12 +1307,30 @@ finish:
 	return IRQ_HANDLED;
 }
 
+/*
+ * UERSTAT only reflects the byte at the head of the RX FIFO and UFSTAT has
+ * no error flag, so a batch read cannot tell which of its bytes had an
+ * error. The drain hands bytes to the tty without per-character flags in
+ * either case, so batching only costs the icount error counters and the
+ * rxerr logs of bytes behind the head. Keep the paired read for consoles,
+ * which need break and sysrq handling, and when INPCK asks for errors.
+ */
+static bool exynos_serial_rx_bulk(struct uart_port *port)
+{
+	if ((port->flags & UPF_CONS_FLOW) || uart_console(port))
+		return false;
+
+	return !(port->read_status_mask & (S3C2410_UERSTAT_FRAME |
+					   S3C2410_UERSTAT_PARITY));
+}
+
 static void exynos_serial_rx_drain_fifo(struct exynos_uart_port *ourport)
 {
 	struct uart_port *port = &ourport->port;
-	unsigned int ufcon, ch, flag, ufstat, uerstat;
+	unsigned int ufcon, ch, flag, ufstat, uerstat, pending_err = 0;
 	unsigned int fifocnt = 0;
 	int max_count = port->fifosize;
+	bool bulk = exynos_serial_rx_bulk(port);
 	unsigned char insert_buf[256] = {0, };
 	unsigned int insert_cnt = 0;
 	unsigned char trace_buf[256] = {0, };
@@ -1201,10 +1350,39 @@ static void exynos_serial_rx_drain_fifo(struct exynos_uart_port *ourport)
 			fifocnt = exynos_serial_rx_fifocnt(ourport, ufstat);
 			if (fifocnt == 0)
 				break;
+
+			/*
+			 * Nothing to flag at the head: read the batch straight
+			 * out of URXH instead of pairing every byte with a
+			 * UERSTAT read. Errors on the later bytes go unseen,
+			 * see exynos_serial_rx_bulk().
+			 */
+			if (bulk) {
+				pending_err = rd_regl(port, S3C2410_UERSTAT);
+				if (!(pending_err & S3C2410_UERSTAT_ANY)) {
+					int n = min_t(int, fifocnt, max_count + 1);
+
+					rd_reg_rep(port, S3C2410_URXH,
+						   &insert_buf[insert_cnt], n);
+					if (ourport->uart_logging) {
+						memcpy(&trace_buf[trace_cnt],
+						       &insert_buf[insert_cnt], n);
+						trace_cnt += n;
+					}
+					insert_cnt += n;
+					port->icount.rx += n;
+					max_count -= n - 1;
+					fifocnt -= n;
+					pending_err = 0;
+					continue;
+				}
+			}
 		}
 		fifocnt--;
 
-		uerstat = rd_regl(port, S3C2410_UERSTAT);
+		/* UERSTAT clears on read, keep what the bulk check saw */
+		uerstat = rd_regl(port, S3C2410_UERSTAT) | pending_err;
+		pending_err = 0;
 		ch = rd_reg(port, S3C2410_URXH);
 
 		if (port->flags & UPF_CONS_FLOW) {
@@ -1546,6 +1724,11 @@ static int exynos_serial_request_dma(struct exynos_uart_port *ourport)
 
 	dmaengine_slave_config(dma->rx_chan, &dma->rx_conf);
 
+	/* __pl330_prep_dma_cyclic() only understands PL330 channels */
+	dma->rx_cyclic = IS_REACHABLE(CONFIG_PL330_DMA_GS) &&
+		!strcmp(dev_driver_string(dma->rx_chan->device->dev),
+			"dma-pl330");
+
 	dma->tx_chan = dma_request_chan(ourport->port.dev, "tx");
 	if (IS_ERR(dma->tx_chan)) {
 		reason = "DMA TX channel request failed";
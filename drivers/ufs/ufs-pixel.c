@@ -306,11 +306,97 @@ static inline void __sync_io_stats(struct ufs_hba *hba)
 	ufs->peak_queue_depth = ufs->curr_io_stats.rw_max_diff_req_count;
 }
 
+static inline int pixel_lat_bucket(u64 delta_us)
+{
+	return min_t(int, fls64(delta_us), PIXEL_LAT_HIST_BUCKETS - 1);
+}
+
+static inline enum pixel_size_class pixel_size_class(u32 bytes)
+{
+	if (bytes <= SZ_4K)
+		return SIZE_CLASS_4K;
+	if (bytes <= SZ_16K)
+		return SIZE_CLASS_16K;
+	if (bytes <= SZ_128K)
+		return SIZE_CLASS_128K;
+	return SIZE_CLASS_LARGE;
+}
+
+/* returns the upper bound in usec of the bucket holding the percentile */
+static u64 pixel_lat_percentile(const u64 *cnt, u64 total, u64 permille)
+{
+	u64 target = div64_u64(total * permille + 999, 1000);
+	u64 acc = 0;
+	int b;
+
+	for (b = 0; b < PIXEL_LAT_HIST_BUCKETS; b++) {
+		acc += cnt[b];
+		if (acc >= target)
+			return 1ULL << b;
+	}
+	return 1ULL << (PIXEL_LAT_HIST_BUCKETS - 1);
+}
+
+static void __sync_lat_row(struct pixel_ufs *ufs, int type,
+			   u64 *p50, u64 *p99, u64 *p999)
+{
+	u64 *prev = ufs->prev_lat_hist.type[type];
+	u64 cnt[PIXEL_LAT_HIST_BUCKETS];
+	u64 total = 0;
+	int b, cpu;
+
+	for (b = 0; b < PIXEL_LAT_HIST_BUCKETS; b++) {
+		u64 val = 0;
+
+		for_each_possible_cpu(cpu)
+			val += per_cpu_ptr(ufs->lat_hist, cpu)->type[type][b];
+		cnt[b] = val - prev[b];
+		prev[b] = val;
+		total += cnt[b];
+	}
+
+	if (!total) {
+		*p50 = *p99 = *p999 = 0;
+		return;
+	}
+	*p50 = pixel_lat_percentile(cnt, total, 500);
+	*p99 = pixel_lat_percentile(cnt, total, 990);
+	*p999 = pixel_lat_percentile(cnt, total, 999);
+}
+
+static inline void __sync_lat_hist(struct ufs_hba *hba,
+				   struct pixel_lat_summary *sum)
+{
+	struct pixel_ufs *ufs = to_pixel_ufs(hba);
+	u64 now = ktime_to_us(ktime_get());
+	u64 busy = 0;
+	int cpu;
+
+	memset(sum, 0, sizeof(*sum));
+	if (!ufs->lat_hist)
+		return;
+
+	__sync_lat_row(ufs, REQ_TYPE_READ, &sum->read_p50, &sum->read_p99,
+		       &sum->read_p999);
+	__sync_lat_row(ufs, REQ_TYPE_WRITE, &sum->write_p50, &sum->write_p99,
+		       &sum->write_p999);
+
+	/* Busy time summed over the requests divided by the elapsed time */
+	for_each_possible_cpu(cpu)
+		busy += per_cpu_ptr(ufs->lat_hist, cpu)->rw_busy_us;
+	if (ufs->lat_sync_us && now > ufs->lat_sync_us)
+		sum->avg_qdepth = div64_u64((busy - ufs->prev_lat_hist.rw_busy_us) * 100,
+					    now - ufs->lat_sync_us);
+	ufs->prev_lat_hist.rw_busy_us = busy;
+	ufs->lat_sync_us = now;
+}
+
 static inline void record_ufs_stats(struct ufs_hba *hba)
 {
 	struct pixel_ufs *ufs = to_pixel_ufs(hba);
 	int i;
 	u64 avg_time[REQ_TYPE_MAX] = { 0, };
+	struct pixel_lat_summary lat_sum;
 
 	if (time_is_after_jiffies(next_period_ufs_stats))
 		return;
@@ -329,6 +415,8 @@ static inline void record_ufs_stats(struct ufs_hba *hba)
 
 	__sync_io_stats(hba);
 	trace_ufs_stats(ufs, avg_time);
+	__sync_lat_hist(hba, &lat_sum);
+	trace_ufs_lat_hist(ufs, &lat_sum);
 
 	for (i = 0; i < REQ_TYPE_MAX; i++) {
 		ufs->peak_reqs[i] = 0;
@@ -372,9 +460,54 @@ void pixel_ufs_update_req_stats(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
 	if (delta > ufs->peak_reqs[cmd_type])
 		ufs->peak_reqs[cmd_type] = delta;
 
+	/* this_cpu ops are irq safe, issue and completion may nest on a cpu */
+	if (ufs->lat_hist) {
+		int b = pixel_lat_bucket(delta);
+
+		this_cpu_inc(ufs->lat_hist->type[REQ_TYPE_VALID][b]);
+		this_cpu_inc(ufs->lat_hist->type[cmd_type][b]);
+		if (cmd_type == REQ_TYPE_READ || cmd_type == REQ_TYPE_WRITE) {
+			u32 bytes = blk_rq_bytes(scsi_cmd_to_rq(lrbp->cmd));
+
+			this_cpu_inc(ufs->lat_hist->size[pixel_size_class(bytes)][b]);
+			this_cpu_add(ufs->lat_hist->rw_busy_us, delta);
+		}
+	}
+
 	record_ufs_stats(hba);
 }
 
+/*
+ * qd_state packs the time of the last R/W issue or completion, in usec,
+ * above the number of R/W requests in flight since then, so both change
+ * together in one cmpxchg.
+ */
+#define PIXEL_QD_STATE_SHIFT		6
+#define PIXEL_QD_STATE_MASK		((1ULL << PIXEL_QD_STATE_SHIFT) - 1)
+
+static inline void __update_qd_time(struct pixel_ufs *ufs, bool is_start)
+{
+	s64 old = atomic64_read(&ufs->qd_state);
+	u64 now, last, new;
+	int depth;
+
+	do {
+		now = ktime_to_us(ktime_get());
+		last = (u64)old >> PIXEL_QD_STATE_SHIFT;
+		depth = old & PIXEL_QD_STATE_MASK;
+		new = max(now, last) << PIXEL_QD_STATE_SHIFT;
+		if (is_start)
+			new |= min_t(u64, depth + 1, PIXEL_QD_STATE_MASK);
+		else if (depth)
+			new |= depth - 1;
+	} while (!atomic64_try_cmpxchg(&ufs->qd_state, &old, new));
+
+	/* charge the time since the last change to the depth it left */
+	if (last && now > last)
+		this_cpu_add(ufs->lat_hist->qd_time_us[min(depth,
+			     PIXEL_QD_HIST_BUCKETS - 1)], now - last);
+}
+
 static inline void __update_io_stats(struct ufs_hba *hba,
 				     bool is_write,
 				     u32 affected_bytes, bool is_start)
@@ -382,6 +515,9 @@ static inline void __update_io_stats(struct ufs_hba *hba,
 	struct pixel_ufs *ufs = to_pixel_ufs(hba);
 	struct pixel_io_stats *s;
 
+	if (ufs->lat_hist)
+		__update_qd_time(ufs, is_start);
+
 	if (!ufs->io_stats)
 		return;
 
@@ -1686,6 +1822,117 @@ static const struct attribute_group pixel_sysfs_io_stats_group = {
 	.attrs = ufs_sysfs_io_stats,
 };
 
+static void pixel_init_lat_hist(struct ufs_hba *hba)
+{
+	struct pixel_ufs *ufs = to_pixel_ufs(hba);
+	int cpu;
+
+	memset(&ufs->prev_lat_hist, 0, sizeof(ufs->prev_lat_hist));
+	ufs->lat_sync_us = 0;
+	atomic64_set(&ufs->qd_state, 0);
+
+	ufs->lat_hist = alloc_percpu(struct pixel_lat_hist);
+	if (!ufs->lat_hist) {
+		dev_err(hba->dev, "%s: failed on lat_hist alloc_percpu()\n",
+			__func__);
+		return;
+	}
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(ufs->lat_hist, cpu), 0,
+			sizeof(struct pixel_lat_hist));
+}
+
+/* prints one line of bucket counts, summed over all cpus */
+#define PIXEL_LAT_HIST_ATTR(_name, _field, _nr)				\
+static ssize_t _name##_show(struct device *dev,				\
+	struct device_attribute *attr, char *buf)			\
+{									\
+	struct ufs_hba *hba = dev_get_drvdata(dev);			\
+	struct pixel_ufs *ufs = to_pixel_ufs(hba);			\
+	int b, cpu, len = 0;						\
+									\
+	if (!ufs->lat_hist)						\
+		return -ENODEV;						\
+									\
+	for (b = 0; b < (_nr); b++) {					\
+		u64 val = 0;						\
+									\
+		for_each_possible_cpu(cpu)				\
+			val += per_cpu_ptr(ufs->lat_hist, cpu)->_field[b]; \
+		len += sysfs_emit_at(buf, len, "%llu%c", val,		\
+				     b == (_nr) - 1 ? '\n' : ' ');	\
+	}								\
+	return len;							\
+}									\
+static DEVICE_ATTR_RO(_name)
+
+static ssize_t reset_lat_hist_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return 0;
+}
+
+static ssize_t reset_lat_hist_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct pixel_ufs *ufs = to_pixel_ufs(hba);
+	int cpu;
+	unsigned long flags;
+
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	if (ufs->lat_hist)
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(ufs->lat_hist, cpu), 0,
+				sizeof(struct pixel_lat_hist));
+	memset(&ufs->prev_lat_hist, 0, sizeof(ufs->prev_lat_hist));
+	ufs->lat_sync_us = 0;
+	/* keep the in-flight count, the next change starts a new interval */
+	atomic64_and(PIXEL_QD_STATE_MASK, &ufs->qd_state);
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+
+	return count;
+}
+
+PIXEL_LAT_HIST_ATTR(all, type[REQ_TYPE_VALID], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(read, type[REQ_TYPE_READ], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(write, type[REQ_TYPE_WRITE], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(flush, type[REQ_TYPE_FLUSH], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(discard, type[REQ_TYPE_DISCARD], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(security, type[REQ_TYPE_SECURITY],
+		    PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(other, type[REQ_TYPE_OTHER], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(size_4k, size[SIZE_CLASS_4K], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(size_16k, size[SIZE_CLASS_16K], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(size_128k, size[SIZE_CLASS_128K], PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(size_large, size[SIZE_CLASS_LARGE],
+		    PIXEL_LAT_HIST_BUCKETS);
+PIXEL_LAT_HIST_ATTR(queue_depth_us, qd_time_us, PIXEL_QD_HIST_BUCKETS);
+DEVICE_ATTR_RW(reset_lat_hist);
+
+static struct attribute *ufs_sysfs_lat_hist[] = {
+	&dev_attr_all.attr,
+	&dev_attr_read.attr,
+	&dev_attr_write.attr,
+	&dev_attr_flush.attr,
+	&dev_attr_discard.attr,
+	&dev_attr_security.attr,
+	&dev_attr_other.attr,
+	&dev_attr_size_4k.attr,
+	&dev_attr_size_16k.attr,
+	&dev_attr_size_128k.attr,
+	&dev_attr_size_large.attr,
+	&dev_attr_queue_depth_us.attr,
+	&dev_attr_reset_lat_hist.attr,
+	NULL,
+};
+
+static const struct attribute_group pixel_sysfs_lat_hist_group = {
+	.name = "lat_hist",
+	.attrs = ufs_sysfs_lat_hist,
+};
+
 #define PIXEL_ERR_STATS_ATTR(_name, _err_name, _type)			\
 static ssize_t _name##_show(struct device *dev,				\
 		struct device_attribute *attr, char *buf)		\
@@ -1958,6 +2205,7 @@ static const struct attribute_group *pixel_ufs_sysfs_groups[] = {
 	&pixel_sysfs_group,
 	&pixel_sysfs_req_stats_group,
 	&pixel_sysfs_io_stats_group,
+	&pixel_sysfs_lat_hist_group,
 	&pixel_sysfs_err_stats_group,
 	&pixel_sysfs_ufs_stats_group,
 	&pixel_sysfs_hc_register_ifc_group,
@@ -2108,6 +2356,8 @@ int pixel_init(struct ufs_hba *hba, struct device *pdev,
 
 	pixel_init_io_stats(hba);
 
+	pixel_init_lat_hist(hba);
+
 	return 0;
 }
 
@@ -2116,4 +2366,6 @@ void pixel_exit(struct ufs_hba *hba)
 	struct pixel_ufs *ufs = to_pixel_ufs(hba);
 
 	devm_kfree(ufs->dev, ufs->cmd_log.entry);
+	free_percpu(ufs->lat_hist);
+	ufs->lat_hist = NULL;
 }
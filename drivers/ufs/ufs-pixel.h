@@ -122,6 +122,52 @@ struct pixel_io_stats {
 
 extern void pixel_init_io_stats(struct ufs_hba *hba);
 
+/*
+ * Latency histograms use log2 buckets in usec: bucket 0 counts requests
+ * below 1us, bucket n counts [2^(n-1), 2^n) and the last one is open.
+ */
+#define PIXEL_LAT_HIST_BUCKETS		21
+/* queue depth histogram buckets, the last one gathers depth >= 32 */
+#define PIXEL_QD_HIST_BUCKETS		33
+
+enum pixel_size_class {
+	SIZE_CLASS_4K = 0,
+	SIZE_CLASS_16K = 1,
+	SIZE_CLASS_128K = 2,
+	SIZE_CLASS_LARGE = 3,
+	SIZE_CLASS_MAX = 4,
+};
+
+/**
+ * struct pixel_lat_hist - per-cpu request latency distribution
+ * @type: latency buckets per request type
+ * @size: latency buckets per transfer size class
+ * @qd_time_us: time in usec spent at each in-flight R/W queue depth
+ * @rw_busy_us: summed issue to completion time of R/W requests, in usec
+ */
+struct pixel_lat_hist {
+	u64 type[REQ_TYPE_MAX][PIXEL_LAT_HIST_BUCKETS];
+	u64 size[SIZE_CLASS_MAX][PIXEL_LAT_HIST_BUCKETS];
+	u64 qd_time_us[PIXEL_QD_HIST_BUCKETS];
+	u64 rw_busy_us;
+};
+
+/**
+ * struct pixel_lat_summary - latency percentiles over one stats period
+ * @read_p50, @read_p99, @read_p999: read percentiles (usec upper bound)
+ * @write_p50, @write_p99, @write_p999: write percentiles (usec upper bound)
+ * @avg_qdepth: average in-flight R/W requests (Little's law), scaled by 100
+ */
+struct pixel_lat_summary {
+	u64 read_p50;
+	u64 read_p99;
+	u64 read_p999;
+	u64 write_p50;
+	u64 write_p99;
+	u64 write_p999;
+	u64 avg_qdepth;
+};
+
 /**
  * struct latency_metrics - generic metrics collection
  * @count: total count of operations
@@ -339,6 +385,12 @@ struct pixel_ufs {
 	struct pixel_io_stats __percpu *io_stats;
 	struct pixel_io_stats curr_io_stats;
 	struct pixel_io_stats prev_io_stats;
+	/* pixel ufs latency and queue depth distribution */
+	struct pixel_lat_hist __percpu *lat_hist;
+	struct pixel_lat_hist prev_lat_hist;
+	u64 lat_sync_us;
+	/* last queue depth change in usec and the in-flight R/W requests */
+	atomic64_t qd_state;
 
 	/* To monitor slow UFS I/O requests. */
 	u64 slowio_min_us;
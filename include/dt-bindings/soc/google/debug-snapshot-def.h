@@ -136,6 +136,7 @@
 #define DSS_LOG_THERMAL		"thermal_log"
 #define DSS_LOG_ACPM		"acpm_log"
 #define DSS_LOG_PRINTK		"printk_log"
+#define DSS_LOG_PRINTK_BIN	"printk_bin_log"
 
 /* MODE */
 #define NONE_DUMP		0
@@ -23,4 +23,21 @@ extern int exynos_pcie_l1ss_ctrl(int enable, int id);
 extern int exynos_pcie_rc_l1ss_ctrl(int enable, int id, int ch_num);
 #endif
 
+#if IS_ENABLED(CONFIG_PCI_EXYNOS_GS)
+struct page;
+
+/*
+ * Keep a fixed set of RX buffers permanently mapped for the EP. Each page is
+ * a naturally aligned block of (PAGE_SIZE << order) bytes. dma_map_page() on
+ * a registered page returns its IOVA without touching the S2MPU/SysMMU.
+ * Register before the EP maps any buffer, it fails with -EBUSY while pages
+ * mapped the normal way are still in flight. Unregister only once none of
+ * the pages is in flight. Registering fails with -ENODEV on SoCs without the
+ * PCIe DMA ops.
+ */
+extern int exynos_pcie_rc_rx_pool_register(int ch_num, struct page **pages,
+					   int nr_pages, unsigned int order);
+extern void exynos_pcie_rc_rx_pool_unregister(int ch_num);
+#endif
+
 #endif
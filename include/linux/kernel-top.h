@@ -7,14 +7,28 @@
 #ifndef _LINUX_KERNEL_TOP_FUNC_H
 #define _LINUX_KERNEL_TOP_FUNC_H
 
+#include <linux/sched.h>
+
 struct kernel_top_context;
 
+struct kernel_top_entry {
+	pid_t pid;
+	char comm[TASK_COMM_LEN];
+	u64 runtime;
+};
+
 #if IS_ENABLED(CONFIG_KERNEL_TOP)
+extern int kernel_top_snapshot(struct kernel_top_entry *top, int n, u64 *total);
 extern void kernel_top_print(struct kernel_top_context *cxt);
 extern int kernel_top_init(struct device *dev, struct kernel_top_context **pcxt);
 extern void kernel_top_reset(struct kernel_top_context *cxt);
 extern void kernel_top_destroy(struct kernel_top_context *cxt);
 #else
+static inline int kernel_top_snapshot(struct kernel_top_entry *top, int n, u64 *total)
+{
+	return 0;
+}
+
 static inline void kernel_top_print(struct kernel_top_context *cxt)
 {
 }
@@ -93,6 +93,22 @@ struct s3c64xx_spi_dma_data {
 	unsigned long dmach;
 };
 
+/**
+ * struct s3c64xx_spi_pio - Progress of an interrupt-driven CPU transfer.
+ * @tx_buf: Data to shift out, or NULL to clock out zeroes.
+ * @rx_buf: Buffer for received data, or NULL to discard it.
+ * @len: Transfer length in words.
+ * @tx_pos: Words pushed into the TX FIFO so far.
+ * @rx_pos: Words pulled from the RX FIFO so far.
+ */
+struct s3c64xx_spi_pio {
+	const void *tx_buf;
+	void *rx_buf;
+	unsigned int len;
+	unsigned int tx_pos;
+	unsigned int rx_pos;
+};
+
 /**
  * struct s3c64xx_spi_driver_data - Runtime info holder for SPI driver.
  * @clk: Pointer to the spi clock.
@@ -111,6 +127,8 @@ struct s3c64xx_spi_dma_data {
  * @cur_mode: Stores the active configuration of the controller.
  * @cur_bpw: Stores the active bits per word settings.
  * @cur_speed: Stores the active xfer clock speed.
+ * @pio: State of the FIFO-level interrupt driven CPU transfer.
+ * @dma_min_len: Largest transfer, in bytes, moved by the CPU in DMA mode.
  */
 struct s3c64xx_spi_driver_data {
 	void __iomem                    *regs;
@@ -130,6 +148,8 @@ struct s3c64xx_spi_driver_data {
 	struct s3c64xx_spi_dma_data	rx_dma;
 	struct s3c64xx_spi_dma_data	tx_dma;
 	struct samsung_dma_ops		*ops;
+	struct s3c64xx_spi_pio		pio;
+	unsigned int			dma_min_len;
 
 	struct s3c64xx_spi_port_config	*port_conf;
 	unsigned int			port_id;
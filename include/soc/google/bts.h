@@ -11,6 +11,8 @@
 #include <linux/errno.h>
 #include <linux/types.h>
 
+struct nocl_info;
+
 /**
  * @BTS_HIST_BIN: Number of bins of the histogram.
  * @bw_trip:      The trip points for each histogram bin.
@@ -67,6 +69,7 @@ struct bts_bw {
 #if IS_ENABLED(CONFIG_SOC_ZUMA)
 	struct list_head node;
 	unsigned int bus_width;
+	struct nocl_info *nocl;
 #endif
 	char *name;
 	bool is_rt;
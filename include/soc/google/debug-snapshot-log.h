@@ -151,6 +151,13 @@ struct print_log {
 	char log[DSS_LOG_STRING_LEN];
 };
 
+struct print_bin_log {
+	unsigned long long time;
+	const char *fmt;
+	int nr_args;
+	u64 args[DSS_PRINT_BIN_MAX_ARGS];
+};
+
 struct itmon_logs {
 	u32 magic;
 	char log[DSS_ITMON_LOG_MAX_LEN];
@@ -170,7 +177,8 @@ struct dbg_snapshot_log {
 	struct regulator_log regulator[DSS_LOG_MAX_NUM];
 	struct thermal_log thermal[DSS_LOG_MAX_NUM];
 	struct acpm_log acpm[DSS_LOG_MAX_NUM];
-	struct print_log print[DSS_LOG_MAX_NUM * 2];
+	struct print_log print[DSS_NR_CPUS][DSS_LOG_MAX_NUM / 8];
+	struct print_bin_log print_bin[DSS_NR_CPUS][DSS_LOG_MAX_NUM / 8];
 };
 
 struct dbg_snapshot_log_misc {
@@ -186,7 +194,8 @@ struct dbg_snapshot_log_misc {
 	atomic_t dm_log_idx;
 	atomic_t regulator_log_idx;
 	atomic_t thermal_log_idx;
-	atomic_t print_log_idx;
+	atomic_t print_log_idx[DSS_NR_CPUS];
+	atomic_t print_bin_log_idx[DSS_NR_CPUS];
 	atomic_t acpm_log_idx;
 };
 #endif
@@ -17,10 +17,12 @@
 #include <asm/cputype.h>
 #include <asm/barrier.h>
 #if IS_ENABLED(CONFIG_DEBUG_SNAPSHOT)
+#include <linux/kernel.h>
 #include <linux/sched/clock.h>
 
 #define DSS_FREQ_MAX_SIZE		SZ_32
 #define DSS_FREQ_MAX_NAME_SIZE		SZ_8
+#define DSS_PRINT_BIN_MAX_ARGS		6
 
 struct clk;
 struct clk_hw;
@@ -101,6 +103,8 @@ extern void dbg_snapshot_freq(int type, unsigned long old_freq,
 extern void dbg_snapshot_dm(int type, unsigned long min, unsigned long max,
 				s32 wait_t, s32 t);
 extern void dbg_snapshot_printk(const char *fmt, ...);
+extern void __dbg_snapshot_printk_bin(const char *fmt, int nr_args,
+				const u64 *args);
 void dbg_snapshot_itmon_backup_log(const char *fmt, ...);
 void dbg_snapshot_itmon_irq_received(void);
 
@@ -125,6 +129,32 @@ extern struct item##_log *dss_get_##item##_log_by_idx(int idx);		\
 extern struct item##_log *dss_get_##item##_log_iter(int idx);		\
 extern unsigned long dss_get_vaddr_##item##_log(void)
 
+#define __dss_bin_arg(x)		((u64)(unsigned long)(x))
+#define __dss_bin_args0()
+#define __dss_bin_args1(a)		__dss_bin_arg(a)
+#define __dss_bin_args2(a, ...)		__dss_bin_arg(a), __dss_bin_args1(__VA_ARGS__)
+#define __dss_bin_args3(a, ...)		__dss_bin_arg(a), __dss_bin_args2(__VA_ARGS__)
+#define __dss_bin_args4(a, ...)		__dss_bin_arg(a), __dss_bin_args3(__VA_ARGS__)
+#define __dss_bin_args5(a, ...)		__dss_bin_arg(a), __dss_bin_args4(__VA_ARGS__)
+#define __dss_bin_args6(a, ...)		__dss_bin_arg(a), __dss_bin_args5(__VA_ARGS__)
+
+/*
+ * dbg_snapshot_printk_bin - log without formatting
+ * @fmt: string literal, kept by pointer and formatted when the log is dumped
+ *
+ * Up to DSS_PRINT_BIN_MAX_ARGS integer or pointer arguments are stored raw.
+ * "%s" arguments must point to memory which outlives the log. Entries of a
+ * module are dropped when it is unloaded.
+ */
+#define dbg_snapshot_printk_bin(fmt, ...)					\
+do {										\
+	u64 __dss_args[DSS_PRINT_BIN_MAX_ARGS] = {				\
+		CONCATENATE(__dss_bin_args, COUNT_ARGS(__VA_ARGS__))(__VA_ARGS__) \
+	};									\
+										\
+	__dbg_snapshot_printk_bin("" fmt, COUNT_ARGS(__VA_ARGS__), __dss_args);\
+} while (0)
+
 static inline void dbg_snapshot_spin_func(void)
 {
         while (1)
@@ -146,6 +176,7 @@ static inline void dbg_snapshot_spin_func(void)
 #define dbg_snapshot_hrtimer(a, b, c, d)	do { } while (0)
 #define dbg_snapshot_dm(a, b, c, d, e)		do { } while (0)
 #define dbg_snapshot_printk(...)		do { } while (0)
+#define dbg_snapshot_printk_bin(...)		do { } while (0)
 #define dbg_snapshot_itmon_backup_log(a)	do { } while (0)
 #define dbg_snapshot_itmon_irq_received(a)	do { } while (0)
 
@@ -295,7 +326,8 @@ dss_extern_get_log(dm);
 dss_extern_get_log(regulator);
 dss_extern_get_log(thermal);
 dss_extern_get_log(acpm);
-dss_extern_get_log(print);
+dss_extern_get_log_by_cpu(print);
+dss_extern_get_log_by_cpu(print_bin);
 
 /**
  * dsslog_flag - added log information supported.
@@ -342,6 +374,7 @@ enum dss_log_item_indx {
 	DSS_LOG_THERMAL_ID,
 	DSS_LOG_ACPM_ID,
 	DSS_LOG_PRINTK_ID,
+	DSS_LOG_PRINTK_BIN_ID,
 };
 
 struct dbg_snapshot_helper_ops {
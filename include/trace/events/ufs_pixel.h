@@ -89,6 +89,40 @@ TRACE_EVENT(ufs_stats,
 		__entry->r_rem, __entry->w_rem, __entry->peak_qdepth
 	)
 );
+
+TRACE_EVENT(ufs_lat_hist,
+	TP_PROTO(struct pixel_ufs *ufs, struct pixel_lat_summary *sum),
+
+	TP_ARGS(ufs, sum),
+
+	TP_STRUCT__entry(
+		__field(u64,	read_p50)
+		__field(u64,	read_p99)
+		__field(u64,	read_p999)
+		__field(u64,	write_p50)
+		__field(u64,	write_p99)
+		__field(u64,	write_p999)
+		__field(u64,	avg_qdepth)
+	),
+
+	TP_fast_assign(
+		__entry->read_p50	= sum->read_p50;
+		__entry->read_p99	= sum->read_p99;
+		__entry->read_p999	= sum->read_p999;
+		__entry->write_p50	= sum->write_p50;
+		__entry->write_p99	= sum->write_p99;
+		__entry->write_p999	= sum->write_p999;
+		__entry->avg_qdepth	= sum->avg_qdepth;
+	),
+
+	TP_printk(
+		"p50/p99/p999(us): read(%llu/%llu/%llu) "
+		"write(%llu/%llu/%llu), avg_queue_depth: %llu.%02llu",
+		__entry->read_p50, __entry->read_p99, __entry->read_p999,
+		__entry->write_p50, __entry->write_p99, __entry->write_p999,
+		__entry->avg_qdepth / 100, __entry->avg_qdepth % 100
+	)
+);
 #endif /* if !defined(_TRACE_UFS_PIXEL_H) || defined(TRACE_HEADER_MULTI_READ) */
 
 /* This part must be outside protection */